@@ -30,7 +30,7 @@
 // Design Name: Ubuntu block device driver
 // File Name: enc_pcie.c
 //
-// Version: v1.1.0
+// Version: v1.3.0
 //
 // Description:
 //   - Ubuntu block device driver.
@@ -39,6 +39,12 @@
 //////////////////////////////////////////////////////////////////////////////////
 // Revision History:
 //
+// * v1.3.0
+//   - accept REQ_FLUSH and REQ_FUA, data with flush or FUA is sent as a single FUA write
+//
+// * v1.2.0
+//   - completion ring with a phase bit, firmware posts an entry by a single DMA
+//
 // * v1.1.0
 //   - Support shutdown command (not ATA command)
 //   - Move sector count information from driver to device firmware
@@ -82,9 +88,8 @@ int setup_cmd(struct request_cmd *requestCmd, struct bio *bio, struct ssd_dev_qu
 	//printk(KERN_DEBUG "setup_cmd\n");
 	physSegments = bio_phys_segments(devQueue->queue, bio);
 	
-	if( (bio->bi_rw & REQ_FLUSH) || !physSegments ) {
+	if( !physSegments ) {
 		requestCmd->reqIO.Cmd = IDE_COMMAND_FLUSH_CACHE;
-		printk(KERN_DEBUG "IDE_COMMAND_FLUSH_CACHE: %x, %x\n", (__u32)(bio->bi_rw & REQ_FLUSH) ,bio_phys_segments(devQueue->queue, bio));
 	}
 	else {
 		if( bio_data_dir(bio) == READ ) {
@@ -92,7 +97,11 @@ int setup_cmd(struct request_cmd *requestCmd, struct bio *bio, struct ssd_dev_qu
 			requestCmd->direction = READ;
 		}
 		else {
-			requestCmd->reqIO.Cmd = IDE_COMMAND_WRITE_DMA;
+			//FUA write of the device drains its whole write cache, so it also serves the preflush
+			if( bio->bi_rw & (REQ_FLUSH | REQ_FUA) )
+				requestCmd->reqIO.Cmd = IDE_COMMAND_WRITE_DMA_FUA_EXT;
+			else
+				requestCmd->reqIO.Cmd = IDE_COMMAND_WRITE_DMA;
 			requestCmd->direction = !READ;
 		}
 			
@@ -279,11 +288,6 @@ int make_bio_request(struct ssd_dev_queue *devQueue, struct bio *bio)
 	//if( (requestHead + 1) % PCIE_REQUEST_DEPTH == requestTail )
 	//	return result;
 
-	if(bio_phys_segments(devQueue->queue, bio) == 0)
-	{
-		printk(KERN_DEBUG "bio_phys_segments(sDev->queue, bio) == 0\n");
-	}
-
 	requestCmd = devQueue->requestList;
 
 	result = setup_cmd(requestCmd, bio, devQueue);
@@ -293,8 +297,6 @@ int make_bio_request(struct ssd_dev_queue *devQueue, struct bio *bio)
 		if( result )
 			goto err_setup_scatter_list;
 	}
-	else
-		printk(KERN_DEBUG "IDE_COMMAND_FLUSH_CACHE: %d\n", bio_phys_segments(devQueue->queue, bio));
 	
 	//requestCmd->valid = 1;
 	requestQueue = devQueue->requestQueue;
@@ -411,13 +413,14 @@ void bio_complete(struct ssd_dev *sDev, struct ssd_dev_queue *devQueue)
 	//printk(KERN_DEBUG "bio_complete\n");
 	//requestTail = devQueue->requestTail;
 
-	completionIO = devQueue->completionQueue;
+	completionIO = &devQueue->completionQueue[devQueue->completionHead];
 
-	//printk(KERN_DEBUG ": %x, deadface checking....\n", completionIO->Done);
+	//printk(KERN_DEBUG ": %x, phase checking....\n", completionIO->Phase);
 
-	if(completionIO->Done == 0xdeadface)
+	//an entry is new when its phase is what we expect in this pass of the ring
+	while(completionIO->Phase == devQueue->completionPhase)
 	{
-//		printk(KERN_DEBUG "deadface checked!!\n");
+//		printk(KERN_DEBUG "phase checked!!\n");
 		debugVar--;
 		requestCmd = devQueue->requestList;
 
@@ -443,9 +446,16 @@ void bio_complete(struct ssd_dev *sDev, struct ssd_dev_queue *devQueue)
 		}
 
 		//requestCmd->valid = 0;
-		completionIO->Done = 0;
 		devQueue->ReqStart = 0;
 		//devQueue->requestTail = (requestTail + 1) % PCIE_REQUEST_DEPTH;
+
+		devQueue->completionHead++;
+		if(devQueue->completionHead == PCIE_COMPLETION_DEPTH)
+		{
+			devQueue->completionHead = 0;
+			devQueue->completionPhase ^= 1;
+		}
+		completionIO = &devQueue->completionQueue[devQueue->completionHead];
 	}
 
 	if(bio_list_peek(&devQueue->bioQueue))
@@ -621,6 +631,7 @@ static struct ssd_dev_queue* alloc_dev_queues(struct ssd_dev *sDev)
 	queue_flag_set(QUEUE_FLAG_NOMERGES, devQueue->queue);
 	queue_flag_set(QUEUE_FLAG_NONROT, devQueue->queue);
 	//queue_flag_set(QUEUE_FLAG_DISCARD, devQueue->queue);
+	blk_queue_flush(devQueue->queue, REQ_FLUSH | REQ_FUA);
 	spin_unlock_irq(devQueue->queue->queue_lock);
 
 	devQueue->requestList = (struct request_cmd *)kmalloc( sizeof(struct request_cmd)*PCIE_REQUEST_DEPTH, GFP_KERNEL);
@@ -642,7 +653,9 @@ static struct ssd_dev_queue* alloc_dev_queues(struct ssd_dev *sDev)
 
 	//devQueue->requestHead = 0;
 	//devQueue->requestTail = 0;
-	//devQueue->completionHead = 0;
+	memset((void *)devQueue->completionQueue, 0, sizeof(struct completion_io)*PCIE_COMPLETION_DEPTH);
+	devQueue->completionHead = 0;
+	devQueue->completionPhase = 1;
 	//devQueue->completionTail = 0;
 	devQueue->ReqStart = 0;
 	
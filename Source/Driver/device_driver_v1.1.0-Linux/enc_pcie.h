@@ -30,7 +30,7 @@
 // Design Name: Ubuntu block device driver
 // File Name: enc_pcie.h
 //
-// Version: v1.1.0
+// Version: v1.3.0
 //
 // Description:
 //   - Ubuntu block device driver.
@@ -39,6 +39,12 @@
 //////////////////////////////////////////////////////////////////////////////////
 // Revision History:
 //
+// * v1.3.0
+//   - accept REQ_FLUSH and REQ_FUA
+//
+// * v1.2.0
+//   - completion ring with a phase bit, firmware posts an entry by a single DMA
+//
 // * v1.1.0
 //   - Support shutdown command (not ATA command)
 //   - Move sector count information from driver to device firmware
@@ -69,7 +75,7 @@
 
 #define PCIE_REQUEST_DEPTH		(1<<0)
 #define PCIE_BIO_DEPTH			(1<<5)
-#define PCIE_COMPLETION_DEPTH		(1<<0)
+#define PCIE_COMPLETION_DEPTH		(1<<6)	//same as firmware, ring fits in a page
 
 #define PCIE_REG_STATUS				(0x00 << 2)
 #define PCIE_REG_INTRRUPT_SET			(0x01 << 2)
@@ -153,9 +159,10 @@ struct request_io {
 };
 
 struct completion_io {
-	__u32	Done;
 	__u32	CmdStatus;
 	__u32	ErrorStatus;
+	__u32	ReqCount;
+	__u32	Phase;
 };
 
 struct scatter_region {
@@ -205,7 +212,8 @@ struct ssd_dev_queue {
 	//spinlock_t rqLock;
 	//volatile unsigned int requestHead;
 	//volatile unsigned int requestTail;
-	//volatile unsigned int completionHead;
+	volatile unsigned int completionHead;
+	volatile unsigned int completionPhase;
 	//volatile unsigned int completionTail;
 	volatile unsigned int ReqStart;
 };
@@ -30,7 +30,7 @@
 // Design Name: ATA
 // File Name: ata.h
 //
-// Version: v1.0.0
+// Version: v1.0.2
 //
 // Description:
 //   - Defining IDE commands, parameters, statuses and errors.
@@ -39,6 +39,12 @@
 //////////////////////////////////////////////////////////////////////////////////
 // Revision History:
 //
+// * v1.0.2
+//   - add vendor command to set over-provisioning
+//
+// * v1.0.1
+//   - add vendor command to read statistics
+//
 // * v1.0.0
 //   - First draft
 //////////////////////////////////////////////////////////////////////////////////
@@ -89,6 +95,8 @@
 #define	IDE_COMMAND_MEDIA_EJECT					0xED
 #define	IDE_COMMAND_SET_FEATURE					0xEF
 #define	IDE_COMMAND_SECURITY_FREEZE_LOCK		0xF5
+#define	IDE_COMMAND_VENDOR_STATS				0xFA	// vendor specific, read statistics region
+#define	IDE_COMMAND_VENDOR_OVER_PROVISION		0xFB	// vendor specific, over-provisioning percent in CurSect from the next boot
 #define	IDE_COMMAND_NOT_VALID					0xFF
 
 // Set features parameter list
@@ -0,0 +1,475 @@
+//////////////////////////////////////////////////////////////////////////////////
+// compress.c for Cosmos OpenSSD
+// Copyright (c) 2014 Hanyang University ENC Lab.
+// Contributed by Yong Ho Song <yhsong@enc.hanyang.ac.kr>
+//                Gyeongyong Lee <gylee@enc.hanyang.ac.kr>
+//			      Jaewook Kwak <jwkwak@enc.hanyang.ac.kr>
+//
+// This file is part of Cosmos OpenSSD.
+//
+// Cosmos OpenSSD is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3, or (at your option)
+// any later version.
+//
+// Cosmos OpenSSD is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Cosmos OpenSSD; see the file COPYING.
+// If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////
+// Company: ENC Lab. <http://enc.hanyang.ac.kr>
+// Engineer: Gyeongyong Lee <gylee@enc.hanyang.ac.kr>
+//			 Jaewook Kwak <jwkwak@enc.hanyang.ac.kr>
+//
+// Project Name: Cosmos OpenSSD
+// Design Name: Greedy FTL
+// Module Name: Compression
+// File Name: compress.c
+//
+// Version: v1.0.5
+//
+// Description:
+//   - inline compression of full pages, LZ4 compressed pages of a die are packed into a container page
+//////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////
+// Revision History:
+//
+// * v1.0.5
+//   - container page is read through the I/O scheduler
+//
+// * v1.0.4
+//   - P2L entries of container pages are set by SetP2L()
+//
+// * v1.0.3
+//   - recovered container page validates each of its sub-pages
+//
+// * v1.0.2
+//   - slots beyond the capacity of the last boot are not remapped at recovery
+//
+// * v1.0.1
+//   - container page read suspends a program or erase of its die
+//
+// * v1.0.0
+//   - First draft
+//////////////////////////////////////////////////////////////////////////////////
+
+#include "compress.h"
+
+#include <assert.h>
+
+#include "lld.h"
+#include "pagemap.h"
+
+#include <string.h>
+
+// LZ4 block format, greedy parsing with a hash table of 4-byte sequences
+#define LZ4_HASH_BITS		12
+#define LZ4_MIN_MATCH		4
+#define LZ4_LAST_LITERALS	5	// the last bytes are always literals
+#define LZ4_MF_LIMIT		12	// no match starts in the last bytes
+#define LZ4_MAX_OFFSET		65535
+
+#define LZ4_READ32(p)		((p)[0] | ((p)[1] << 8) | ((p)[2] << 16) | ((u32)(p)[3] << 24))
+#define LZ4_HASH(v)			(((v) * 2654435761U) >> (32 - LZ4_HASH_BITS))
+
+// positions of earlier calls are harmless, a candidate is accepted only after its bytes are compared
+static u16 lz4Hash[1 << LZ4_HASH_BITS];
+
+void InitCompress()
+{
+#if COMP_ENABLE
+	compMap = (struct compArray*)(COMP_MAP_ADDR);
+
+	u32 dieNo;
+	struct compHeader* header;
+
+	memset(compMap->liveCnt, 0, sizeof(compMap->liveCnt));
+	for(dieNo=0 ; dieNo<DIE_NUM ; dieNo++)
+	{
+		header = (struct compHeader*)(COMP_BUFFER_ADDR + dieNo*PAGE_SIZE);
+		header->slotCnt = 0;
+		compMap->openSize[dieNo] = sizeof(struct compHeader);
+		compMap->openLive[dieNo] = 0;
+	}
+	compMap->compCnt = 0;
+	compMap->containerCnt = 0;
+
+	xil_printf("[ ssd compression initialized. ]\r\n");
+#endif
+}
+
+// 1 if the page is compressed into the open container of the die, the caller programs it otherwise
+int CompressPage(u32 dieNo, u32 dieLpn, u32 bufAddr)
+{
+#if COMP_ENABLE
+	compMap = (struct compArray*)(COMP_MAP_ADDR);
+
+	struct compHeader* header = (struct compHeader*)(COMP_BUFFER_ADDR + dieNo*PAGE_SIZE);
+	u32 size, slot;
+	int i;
+
+	size = Lz4Compress(bufAddr, PAGE_SIZE, COMP_WORK_ADDR, COMP_MAX_SIZE);
+	if(size == 0)
+		return 0;
+
+	for(i=0 ; i<SUB_PAGE_NUM_PER_PAGE ; i++)
+		UpdateMetaForOverwrite(dieNo, dieLpn + i);
+
+	if((header->slotCnt == COMP_SLOT_NUM) || (compMap->openSize[dieNo] + size > PAGE_SIZE))
+		FlushContainer(dieNo);
+
+	slot = header->slotCnt++;
+	header->slot[slot].dieLpn = dieLpn;
+	header->slot[slot].offset = compMap->openSize[dieNo];
+	header->slot[slot].length = size;
+	header->slot[slot].subMask = (1 << SUB_PAGE_NUM_PER_PAGE) - 1;
+
+	// slots are word aligned for the data kernel
+	CopyData(COMP_BUFFER_ADDR + dieNo*PAGE_SIZE + compMap->openSize[dieNo], COMP_WORK_ADDR, (size + 3) / 4 * 4);
+	compMap->openSize[dieNo] += (size + 3) / 4 * 4;
+
+	for(i=0 ; i<SUB_PAGE_NUM_PER_PAGE ; i++)
+		SetL2P(dieNo, dieLpn + i, COMP_ENTRY(COMP_OPEN_PAGE, slot, i));
+	compMap->openLive[dieNo] += SUB_PAGE_NUM_PER_PAGE;
+	compMap->compCnt++;
+
+	return 1;
+#else
+	return 0;
+#endif
+}
+
+// open container is programmed to cold stream, a container whose slots are all overwritten is dropped
+void FlushContainer(u32 dieNo)
+{
+#if COMP_ENABLE
+	compMap = (struct compArray*)(COMP_MAP_ADDR);
+	pageMap = (struct pmArray*)(PAGE_MAP_ADDR);
+
+	struct compHeader* header = (struct compHeader*)(COMP_BUFFER_ADDR + dieNo*PAGE_SIZE);
+	u32 page, slot, bufAddr;
+	int i;
+
+	if(header->slotCnt == 0)
+		return;
+
+	if(compMap->openLive[dieNo])
+	{
+		page = FindFreePage(dieNo, STREAM_COLD);
+
+		// sub-pages overwritten meanwhile are left out of recovery
+		for(slot=0 ; slot<header->slotCnt ; slot++)
+			for(i=0 ; i<SUB_PAGE_NUM_PER_PAGE ; i++)
+				if(GetL2P(dieNo, header->slot[slot].dieLpn + i) != COMP_ENTRY(COMP_OPEN_PAGE, slot, i))
+					header->slot[slot].subMask &= ~(1 << i);
+
+		bufAddr = AllocWriteBuf();
+		CopyData(bufAddr, COMP_BUFFER_ADDR + dieNo*PAGE_SIZE, PAGE_SIZE);
+		ProgramWriteBuf(dieNo, page, bufAddr);
+
+		for(i=0 ; i<SUB_PAGE_NUM_PER_PAGE ; i++)
+		{
+			SetP2L(dieNo, page*SUB_PAGE_NUM_PER_PAGE + i, CONTAINER_4BYTE);
+			SetValid(dieNo, page*SUB_PAGE_NUM_PER_PAGE + i);
+		}
+		compMap->liveCnt[dieNo][page] = compMap->openLive[dieNo];
+
+		for(slot=0 ; slot<header->slotCnt ; slot++)
+			for(i=0 ; i<SUB_PAGE_NUM_PER_PAGE ; i++)
+				if(header->slot[slot].subMask & (1 << i))
+					SetL2P(dieNo, header->slot[slot].dieLpn + i, COMP_ENTRY(page, slot, i));
+
+		compMap->containerCnt++;
+	}
+
+	header->slotCnt = 0;
+	compMap->openSize[dieNo] = sizeof(struct compHeader);
+	compMap->openLive[dieNo] = 0;
+#endif
+}
+
+// the last sub-page leaving a container page invalidates it
+void ReleaseCompSub(u32 dieNo, u32 ppn)
+{
+#if COMP_ENABLE
+	compMap = (struct compArray*)(COMP_MAP_ADDR);
+
+	u32 page = COMP_PAGE(ppn);
+	int i;
+
+	if(page == COMP_OPEN_PAGE)
+		compMap->openLive[dieNo]--;
+	else if(--compMap->liveCnt[dieNo][page] == 0)
+		for(i=0 ; i<SUB_PAGE_NUM_PER_PAGE ; i++)
+			InvalidateSubPage(dieNo, page*SUB_PAGE_NUM_PER_PAGE + i);
+#endif
+}
+
+// address of container data, a programmed container is read into sub-page buffer of the die
+u32 GetContainer(u32 dieNo, u32 page)
+{
+	u32 bufAddr;
+
+	if(page == COMP_OPEN_PAGE)
+		return COMP_BUFFER_ADDR + dieNo*PAGE_SIZE;
+
+	bufAddr = SUB_PAGE_BUFFER_ADDR + dieNo*PAGE_SIZE;
+	if(!IoRead(dieNo, IO_CLASS_HOST_READ, page, bufAddr))
+		WaitWayFree(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM);
+
+	return bufAddr;
+}
+
+void ReadCompPage(u32 dieNo, u32 ppn, u32 bufAddr)
+{
+	u32 container = GetContainer(dieNo, COMP_PAGE(ppn));
+	struct compSlot* slot = &((struct compHeader*)container)->slot[COMP_SLOT(ppn)];
+	u32 size;
+
+	size = Lz4Decompress(container + slot->offset, slot->length, bufAddr, PAGE_SIZE);
+	assert(size == PAGE_SIZE);
+}
+
+void ReadCompSub(u32 dieNo, u32 ppn, u32 bufAddr)
+{
+	ReadCompPage(dieNo, ppn, COMP_WORK_ADDR);
+	CopyData(bufAddr, COMP_WORK_ADDR + COMP_SUB(ppn)*SUB_PAGE_SIZE, SUB_PAGE_SIZE);
+}
+
+// container page copied by GC takes its live slots along, bufAddr holds its data to be programmed
+void MoveContainer(u32 dieNo, u32 oldPage, u32 newPage, u32 bufAddr)
+{
+#if COMP_ENABLE
+	compMap = (struct compArray*)(COMP_MAP_ADDR);
+	pageMap = (struct pmArray*)(PAGE_MAP_ADDR);
+
+	struct compHeader* header = (struct compHeader*)bufAddr;
+	u32 slot, dieLpn;
+	int i;
+
+	for(i=0 ; i<SUB_PAGE_NUM_PER_PAGE ; i++)
+	{
+		SetP2L(dieNo, newPage*SUB_PAGE_NUM_PER_PAGE + i, CONTAINER_4BYTE);
+		SetValid(dieNo, newPage*SUB_PAGE_NUM_PER_PAGE + i);
+	}
+	compMap->liveCnt[dieNo][newPage] = compMap->liveCnt[dieNo][oldPage];
+
+	for(slot=0 ; slot<header->slotCnt ; slot++)
+		for(i=0 ; i<SUB_PAGE_NUM_PER_PAGE ; i++)
+		{
+			dieLpn = header->slot[slot].dieLpn + i;
+			if((header->slot[slot].subMask & (1 << i)) && (GetL2P(dieNo, dieLpn) == COMP_ENTRY(oldPage, slot, i)))
+				SetL2P(dieNo, dieLpn, COMP_ENTRY(newPage, slot, i));
+			else
+				header->slot[slot].subMask &= ~(1 << i);	// copy must not bring back the overwritten data in recovery
+		}
+#endif
+}
+
+// slots of a container page found in a page map page, seq is the write sequence of the container
+void RecoverContainer(u32 dieNo, u32 page, u32 seq)
+{
+#if COMP_ENABLE
+	compMap = (struct compArray*)(COMP_MAP_ADDR);
+	ciBufMap = (struct ciBufArray*)(CI_BUF_MAP_ADDR);
+
+	struct compHeader* header = (struct compHeader*)GetContainer(dieNo, page);
+	u32 dieLpn;
+	int slot, i, k;
+
+	// later slots hold later data of a logical page written twice into the container
+	for(slot=header->slotCnt-1 ; slot>=0 ; slot--)
+		for(i=0 ; i<SUB_PAGE_NUM_PER_PAGE ; i++)
+		{
+			if(!(header->slot[slot].subMask & (1 << i)))
+				continue;
+
+			dieLpn = header->slot[slot].dieLpn + i;
+#if MAP_CACHE_ENABLE
+			if(GetL2P(dieNo, dieLpn) != COMP_ENTRY(page, slot, i))
+				continue;
+#else
+			if(ciBufMap->ciBufEntry[dieLpn / SUB_PAGE_NUM_PER_BLOCK][dieLpn % SUB_PAGE_NUM_PER_BLOCK] >= seq)
+				continue;
+			if(BeyondCapacity(dieNo, dieLpn))
+				continue;
+
+			if(GetL2P(dieNo, dieLpn) != 0xffffffff)
+				ClearRecoveredPpn(dieNo, GetL2P(dieNo, dieLpn));
+			SetL2P(dieNo, dieLpn, COMP_ENTRY(page, slot, i));
+			ciBufMap->ciBufEntry[dieLpn / SUB_PAGE_NUM_PER_BLOCK][dieLpn % SUB_PAGE_NUM_PER_BLOCK] = seq;
+#endif
+			if(compMap->liveCnt[dieNo][page]++ == 0)
+				for(k=0 ; k<SUB_PAGE_NUM_PER_PAGE ; k++)
+					SetValid(dieNo, page*SUB_PAGE_NUM_PER_PAGE + k);
+		}
+#endif
+}
+
+// mapping replaced by newer data found in recovery, a container page stays valid while it has mapped sub-pages
+void ClearRecoveredPpn(u32 dieNo, u32 ppn)
+{
+#if COMP_ENABLE
+	compMap = (struct compArray*)(COMP_MAP_ADDR);
+
+	u32 page;
+	int i;
+
+	if(IS_COMP(ppn))
+	{
+		page = COMP_PAGE(ppn);
+		if(--compMap->liveCnt[dieNo][page] == 0)
+			for(i=0 ; i<SUB_PAGE_NUM_PER_PAGE ; i++)
+				ClearValid(dieNo, page*SUB_PAGE_NUM_PER_PAGE + i);
+		return;
+	}
+#endif
+	ClearValid(dieNo, ppn);
+}
+
+// returns compressed size, 0 if it exceeds dstMax
+u32 Lz4Compress(u32 srcAddr, u32 srcSize, u32 dstAddr, u32 dstMax)
+{
+	u8* src = (u8*)srcAddr;
+	u8* dst = (u8*)dstAddr;
+	u32 ip = 0, anchor = 0, op = 0;
+	u32 ref, seq, h, matchLen, litLen, n;
+	u32 token;
+
+	while(srcSize >= LZ4_MF_LIMIT && ip < srcSize - LZ4_MF_LIMIT)
+	{
+		seq = LZ4_READ32(src + ip);
+		h = LZ4_HASH(seq);
+		ref = lz4Hash[h];
+		lz4Hash[h] = ip;
+
+		if((ref >= ip) || (ip - ref > LZ4_MAX_OFFSET) || (LZ4_READ32(src + ref) != seq))
+		{
+			ip++;
+			continue;
+		}
+
+		matchLen = LZ4_MIN_MATCH;
+		while((ip + matchLen < srcSize - LZ4_LAST_LITERALS) && (src[ref + matchLen] == src[ip + matchLen]))
+			matchLen++;
+
+		// token, literal length, literals, offset and match length in the worst case
+		litLen = ip - anchor;
+		if(op + 1 + litLen/255 + 1 + litLen + 2 + (matchLen - LZ4_MIN_MATCH)/255 + 1 > dstMax)
+			return 0;
+
+		token = op++;
+		if(litLen >= 15)
+		{
+			dst[token] = 15 << 4;
+			for(n=litLen-15 ; n>=255 ; n-=255)
+				dst[op++] = 255;
+			dst[op++] = n;
+		}
+		else
+			dst[token] = litLen << 4;
+
+		for(n=0 ; n<litLen ; n++)
+			dst[op++] = src[anchor + n];
+
+		dst[op++] = (ip - ref) & 0xff;
+		dst[op++] = (ip - ref) >> 8;
+
+		n = matchLen - LZ4_MIN_MATCH;
+		if(n >= 15)
+		{
+			dst[token] |= 15;
+			for(n-=15 ; n>=255 ; n-=255)
+				dst[op++] = 255;
+			dst[op++] = n;
+		}
+		else
+			dst[token] |= n;
+
+		ip += matchLen;
+		anchor = ip;
+	}
+
+	// the rest is a sequence of literals only
+	litLen = srcSize - anchor;
+	if(op + 1 + litLen/255 + 1 + litLen > dstMax)
+		return 0;
+
+	token = op++;
+	if(litLen >= 15)
+	{
+		dst[token] = 15 << 4;
+		for(n=litLen-15 ; n>=255 ; n-=255)
+			dst[op++] = 255;
+		dst[op++] = n;
+	}
+	else
+		dst[token] = litLen << 4;
+
+	for(n=0 ; n<litLen ; n++)
+		dst[op++] = src[anchor + n];
+
+	return op;
+}
+
+// returns decompressed size, 0 for broken data
+u32 Lz4Decompress(u32 srcAddr, u32 srcSize, u32 dstAddr, u32 dstMax)
+{
+	u8* src = (u8*)srcAddr;
+	u8* dst = (u8*)dstAddr;
+	u32 ip = 0, op = 0;
+	u32 token, len, offset, b, n;
+
+	while(ip < srcSize)
+	{
+		token = src[ip++];
+
+		len = token >> 4;
+		if(len == 15)
+			do
+			{
+				b = src[ip++];
+				len += b;
+			} while((b == 255) && (ip < srcSize));
+
+		if((ip + len > srcSize) || (op + len > dstMax))
+			return 0;
+		for(n=0 ; n<len ; n++)
+			dst[op++] = src[ip++];
+
+		if(ip == srcSize)
+			break;
+
+		if(ip + 2 > srcSize)
+			return 0;
+		offset = src[ip] | (src[ip + 1] << 8);
+		ip += 2;
+		if((offset == 0) || (offset > op))
+			return 0;
+
+		len = token & 15;
+		if(len == 15)
+			do
+			{
+				b = src[ip++];
+				len += b;
+			} while((b == 255) && (ip < srcSize));
+		len += LZ4_MIN_MATCH;
+
+		if(op + len > dstMax)
+			return 0;
+
+		// byte by byte, the match may overlap its own output
+		for(n=0 ; n<len ; n++, op++)
+			dst[op] = dst[op - offset];
+	}
+
+	return op;
+}
@@ -0,0 +1,111 @@
+//////////////////////////////////////////////////////////////////////////////////
+// compress.h for Cosmos OpenSSD
+// Copyright (c) 2014 Hanyang University ENC Lab.
+// Contributed by Yong Ho Song <yhsong@enc.hanyang.ac.kr>
+//                Gyeongyong Lee <gylee@enc.hanyang.ac.kr>
+//			      Jaewook Kwak <jwkwak@enc.hanyang.ac.kr>
+//
+// This file is part of Cosmos OpenSSD.
+//
+// Cosmos OpenSSD is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3, or (at your option)
+// any later version.
+//
+// Cosmos OpenSSD is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Cosmos OpenSSD; see the file COPYING.
+// If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////
+// Company: ENC Lab. <http://enc.hanyang.ac.kr>
+// Engineer: Gyeongyong Lee <gylee@enc.hanyang.ac.kr>
+//			 Jaewook Kwak <jwkwak@enc.hanyang.ac.kr>
+//
+// Project Name: Cosmos OpenSSD
+// Design Name: Greedy FTL
+// Module Name: Compression
+// File Name: compress.h
+//
+// Version: v1.0.0
+//
+// Description:
+//   - define container pages packing compressed pages
+//////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////
+// Revision History:
+//
+// * v1.0.0
+//   - First draft
+//////////////////////////////////////////////////////////////////////////////////
+
+#ifndef COMPRESS_H_
+#define COMPRESS_H_
+
+#include "xil_types.h"
+#include "ftl.h"
+
+// L2P entry of a sub-page of a compressed page, the page lies in a slot of a container page
+#define COMP_BASE			0x40000000
+#define COMP_ENTRY(page, slot, sub)	(COMP_BASE + ((page) * COMP_SLOT_NUM + (slot)) * SUB_PAGE_NUM_PER_PAGE + (sub))
+#define COMP_PAGE(ppn)		(((ppn) - COMP_BASE) / SUB_PAGE_NUM_PER_PAGE / COMP_SLOT_NUM)
+#define COMP_SLOT(ppn)		(((ppn) - COMP_BASE) / SUB_PAGE_NUM_PER_PAGE % COMP_SLOT_NUM)
+#define COMP_SUB(ppn)		(((ppn) - COMP_BASE) % SUB_PAGE_NUM_PER_PAGE)
+#define COMP_OPEN_PAGE		PAGE_NUM_PER_DIE	// page number of the container being filled in DRAM
+#if COMP_ENABLE
+#define IS_COMP(ppn)		(((ppn) >= COMP_BASE) && ((ppn) < COMP_ENTRY(COMP_OPEN_PAGE + 1, 0, 0)))
+#else
+#define IS_COMP(ppn)		0
+#endif
+
+// P2L entry of both sub-pages of a container page, L2P entries of its slots are found from its header
+#define CONTAINER_4BYTE		0xfffffffc
+
+// a slot holds LZ4 data of a logical page, subMask tells its sub-pages still mapped when the container is programmed
+struct compSlot {
+	u32 dieLpn;	// first sub-page of the logical page
+	u16 offset;
+	u16 length;
+	u32 subMask;
+};
+
+// header at the start of a container page, slot data follow
+struct compHeader {
+	u32 slotCnt;
+	struct compSlot slot[COMP_SLOT_NUM];
+};
+
+// compressed page is worth a slot only if a container holds two of them at least
+#define COMP_MAX_SIZE		((PAGE_SIZE - sizeof(struct compHeader)) / 2 / 4 * 4)
+
+struct compArray {
+	u8 liveCnt[DIE_NUM][PAGE_NUM_PER_DIE];	// sub-pages mapped to each container page
+	u32 openSize[DIE_NUM];	// bytes used in the open container of each die
+	u32 openLive[DIE_NUM];	// sub-pages mapped to the open container
+	u32 compCnt;	// pages written compressed
+	u32 containerCnt;	// container pages programmed
+};
+
+struct compArray* compMap;
+
+void InitCompress();
+int CompressPage(u32 dieNo, u32 dieLpn, u32 bufAddr);
+void FlushContainer(u32 dieNo);
+void ReleaseCompSub(u32 dieNo, u32 ppn);
+u32 GetContainer(u32 dieNo, u32 page);
+void ReadCompPage(u32 dieNo, u32 ppn, u32 bufAddr);
+void ReadCompSub(u32 dieNo, u32 ppn, u32 bufAddr);
+void MoveContainer(u32 dieNo, u32 oldPage, u32 newPage, u32 bufAddr);
+void RecoverContainer(u32 dieNo, u32 page, u32 seq);
+void ClearRecoveredPpn(u32 dieNo, u32 ppn);
+
+u32 Lz4Compress(u32 srcAddr, u32 srcSize, u32 dstAddr, u32 dstMax);
+u32 Lz4Decompress(u32 srcAddr, u32 srcSize, u32 dstAddr, u32 dstMax);
+
+#endif /* COMPRESS_H_ */
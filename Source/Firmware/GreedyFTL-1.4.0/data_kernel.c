@@ -0,0 +1,205 @@
+//////////////////////////////////////////////////////////////////////////////////
+// wear_level.c for Cosmos OpenSSD
+// Copyright (c) 2014 Hanyang University ENC Lab.
+// Contributed by Yong Ho Song <yhsong@enc.hanyang.ac.kr>
+//                Gyeongyong Lee <gylee@enc.hanyang.ac.kr>
+//			      Jaewook Kwak <jwkwak@enc.hanyang.ac.kr>
+//
+// This file is part of Cosmos OpenSSD.
+//
+// Cosmos OpenSSD is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3, or (at your option)
+// any later version.
+//
+// Cosmos OpenSSD is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Cosmos OpenSSD; see the file COPYING.
+// If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////
+// Company: ENC Lab. <http://enc.hanyang.ac.kr>
+// Engineer: Gyeongyong Lee <gylee@enc.hanyang.ac.kr>
+//			 Jaewook Kwak <jwkwak@enc.hanyang.ac.kr>
+//
+// Project Name: Cosmos OpenSSD
+// Design Name: Greedy FTL
+// Module Name: Data Kernel
+// File Name: data_kernel.c
+//
+// Version: v1.1.0
+//
+// Description:
+//   - page copy, fill pattern detection, popcount and CRC32C of buffers
+//////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////
+// Revision History:
+//
+// * v1.1.0
+//   - add comparison of buffers
+//
+// * v1.0.0
+//   - First draft
+//////////////////////////////////////////////////////////////////////////////////
+
+#include "data_kernel.h"
+
+#if DATA_KERNEL_NEON
+#include <arm_neon.h>
+#endif
+
+// CRC32C (Castagnoli) tables for slicing by 4 bytes, Cortex-A9 has no CRC or 64-bit polynomial multiply instruction
+static u32 crcTable[4][256];
+
+void InitDataKernel()
+{
+	u32 i, j, crc;
+
+	for(i=0 ; i<256 ; i++)
+	{
+		crc = i;
+		for(j=0 ; j<8 ; j++)
+			crc = (crc >> 1) ^ (0x82f63b78 & (0 - (crc & 1)));
+		crcTable[0][i] = crc;
+	}
+
+	for(i=0 ; i<256 ; i++)
+		for(j=1 ; j<4 ; j++)
+			crcTable[j][i] = (crcTable[j-1][i] >> 8) ^ crcTable[0][crcTable[j-1][i] & 0xff];
+}
+
+void CopyData(u32 dstAddr, u32 srcAddr, u32 size)
+{
+	u32* dst = (u32*)dstAddr;
+	u32* src = (u32*)srcAddr;
+	u32 i = 0;
+
+#if DATA_KERNEL_NEON
+	for( ; i + DATA_KERNEL_CHUNK/4 <= size/4 ; i += DATA_KERNEL_CHUNK/4)
+	{
+		uint32x4_t q0 = vld1q_u32(src + i);
+		uint32x4_t q1 = vld1q_u32(src + i + 4);
+		uint32x4_t q2 = vld1q_u32(src + i + 8);
+		uint32x4_t q3 = vld1q_u32(src + i + 12);
+		vst1q_u32(dst + i, q0);
+		vst1q_u32(dst + i + 4, q1);
+		vst1q_u32(dst + i + 8, q2);
+		vst1q_u32(dst + i + 12, q3);
+	}
+#endif
+	for( ; i < size/4 ; i++)
+		dst[i] = src[i];
+}
+
+// 1 if every word of the buffer equals the pattern, e.g. 0 for zero data and 0xffffffff for erased page
+int IsDataFilled(u32 addr, u32 size, u32 pattern)
+{
+	u32* buf = (u32*)addr;
+	u32 i = 0;
+	u32 diff = 0;
+
+#if DATA_KERNEL_NEON
+	uint32x4_t p = vdupq_n_u32(pattern);
+	uint32x4_t acc = vdupq_n_u32(0);
+	for( ; i + DATA_KERNEL_CHUNK/4 <= size/4 ; i += DATA_KERNEL_CHUNK/4)
+	{
+		acc = vorrq_u32(acc, veorq_u32(vld1q_u32(buf + i), p));
+		acc = vorrq_u32(acc, veorq_u32(vld1q_u32(buf + i + 4), p));
+		acc = vorrq_u32(acc, veorq_u32(vld1q_u32(buf + i + 8), p));
+		acc = vorrq_u32(acc, veorq_u32(vld1q_u32(buf + i + 12), p));
+
+		// stop at the first chunk that differs, most non-matching pages differ in the first bytes
+		uint32x2_t d = vorr_u32(vget_low_u32(acc), vget_high_u32(acc));
+		if(vget_lane_u32(d, 0) | vget_lane_u32(d, 1))
+			return 0;
+	}
+#endif
+	for( ; i < size/4 ; i++)
+		diff |= buf[i] ^ pattern;
+
+	return diff == 0;
+}
+
+// 1 if two buffers hold the same data
+int IsDataEqual(u32 addr0, u32 addr1, u32 size)
+{
+	u32* buf0 = (u32*)addr0;
+	u32* buf1 = (u32*)addr1;
+	u32 i = 0;
+	u32 diff = 0;
+
+#if DATA_KERNEL_NEON
+	uint32x4_t acc = vdupq_n_u32(0);
+	for( ; i + DATA_KERNEL_CHUNK/4 <= size/4 ; i += DATA_KERNEL_CHUNK/4)
+	{
+		acc = vorrq_u32(acc, veorq_u32(vld1q_u32(buf0 + i), vld1q_u32(buf1 + i)));
+		acc = vorrq_u32(acc, veorq_u32(vld1q_u32(buf0 + i + 4), vld1q_u32(buf1 + i + 4)));
+		acc = vorrq_u32(acc, veorq_u32(vld1q_u32(buf0 + i + 8), vld1q_u32(buf1 + i + 8)));
+		acc = vorrq_u32(acc, veorq_u32(vld1q_u32(buf0 + i + 12), vld1q_u32(buf1 + i + 12)));
+
+		uint32x2_t d = vorr_u32(vget_low_u32(acc), vget_high_u32(acc));
+		if(vget_lane_u32(d, 0) | vget_lane_u32(d, 1))
+			return 0;
+	}
+#endif
+	for( ; i < size/4 ; i++)
+		diff |= buf0[i] ^ buf1[i];
+
+	return diff == 0;
+}
+
+u32 CountDataBits(u32 addr, u32 size)
+{
+	u32* buf = (u32*)addr;
+	u32 i = 0;
+	u32 count = 0;
+
+#if DATA_KERNEL_NEON
+	// byte counts of a chunk are at most 32 and are widened into 32-bit lanes
+	uint32x4_t acc = vdupq_n_u32(0);
+	for( ; i + DATA_KERNEL_CHUNK/4 <= size/4 ; i += DATA_KERNEL_CHUNK/4)
+	{
+		uint8x16_t c = vcntq_u8(vreinterpretq_u8_u32(vld1q_u32(buf + i)));
+		c = vaddq_u8(c, vcntq_u8(vreinterpretq_u8_u32(vld1q_u32(buf + i + 4))));
+		c = vaddq_u8(c, vcntq_u8(vreinterpretq_u8_u32(vld1q_u32(buf + i + 8))));
+		c = vaddq_u8(c, vcntq_u8(vreinterpretq_u8_u32(vld1q_u32(buf + i + 12))));
+		acc = vpadalq_u16(acc, vpaddlq_u8(c));
+	}
+	uint64x2_t s = vpaddlq_u32(acc);
+	count = (u32)(vgetq_lane_u64(s, 0) + vgetq_lane_u64(s, 1));
+#endif
+	for( ; i < size/4 ; i++)
+		count += CountBits(buf[i]);
+
+	return count;
+}
+
+// SWAR popcount of a word
+int CountBits(u32 i)
+{
+	i = i - ((i >> 1) & 0x55555555);
+	i = (i & 0x33333333) + ((i >> 2) & 0x33333333);
+	return (((i + (i >> 4)) & 0x0F0F0F0F) * 0x01010101) >> 24;
+}
+
+// CRC32C over word aligned buffer, start with CRC32C_INIT and invert the result when done
+u32 Crc32c(u32 crc, u32 addr, u32 size)
+{
+	u32* buf = (u32*)addr;
+	u32 i;
+
+	for(i=0 ; i<size/4 ; i++)
+	{
+		crc ^= buf[i];
+		crc = crcTable[3][crc & 0xff] ^ crcTable[2][(crc >> 8) & 0xff]
+				^ crcTable[1][(crc >> 16) & 0xff] ^ crcTable[0][crc >> 24];
+	}
+
+	return crc;
+}
@@ -0,0 +1,76 @@
+//////////////////////////////////////////////////////////////////////////////////
+// wear_level.h for Cosmos OpenSSD
+// Copyright (c) 2014 Hanyang University ENC Lab.
+// Contributed by Yong Ho Song <yhsong@enc.hanyang.ac.kr>
+//                Gyeongyong Lee <gylee@enc.hanyang.ac.kr>
+//			      Jaewook Kwak <jwkwak@enc.hanyang.ac.kr>
+//
+// This file is part of Cosmos OpenSSD.
+//
+// Cosmos OpenSSD is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3, or (at your option)
+// any later version.
+//
+// Cosmos OpenSSD is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Cosmos OpenSSD; see the file COPYING.
+// If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////
+// Company: ENC Lab. <http://enc.hanyang.ac.kr>
+// Engineer: Gyeongyong Lee <gylee@enc.hanyang.ac.kr>
+//			 Jaewook Kwak <jwkwak@enc.hanyang.ac.kr>
+//
+// Project Name: Cosmos OpenSSD
+// Design Name: Greedy FTL
+// Module Name: Data Kernel
+// File Name: data_kernel.h
+//
+// Version: v1.1.0
+//
+// Description:
+//   - declare kernels to copy and inspect page data
+//////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////
+// Revision History:
+//
+// * v1.1.0
+//   - add comparison of buffers
+//
+// * v1.0.0
+//   - First draft
+//////////////////////////////////////////////////////////////////////////////////
+
+#ifndef DATA_KERNEL_H_
+#define DATA_KERNEL_H_
+
+#include "xil_types.h"
+
+// NEON of Cortex-A9 is used when the compiler targets it (-mfpu=neon), word loops are used otherwise
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#define DATA_KERNEL_NEON	1
+#else
+#define DATA_KERNEL_NEON	0
+#endif
+
+// buffers are word aligned and sizes are multiple of words, NEON loops take 64 bytes at a time
+#define DATA_KERNEL_CHUNK	64
+
+#define CRC32C_INIT			0xffffffff
+
+void InitDataKernel();
+void CopyData(u32 dstAddr, u32 srcAddr, u32 size);
+int IsDataFilled(u32 addr, u32 size, u32 pattern);
+int IsDataEqual(u32 addr0, u32 addr1, u32 size);
+u32 CountDataBits(u32 addr, u32 size);
+int CountBits(u32 i);
+u32 Crc32c(u32 crc, u32 addr, u32 size);
+
+#endif /* DATA_KERNEL_H_ */
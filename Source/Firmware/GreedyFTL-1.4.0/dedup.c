@@ -0,0 +1,257 @@
+//////////////////////////////////////////////////////////////////////////////////
+// dedup.c for Cosmos OpenSSD
+// Copyright (c) 2014 Hanyang University ENC Lab.
+// Contributed by Yong Ho Song <yhsong@enc.hanyang.ac.kr>
+//                Gyeongyong Lee <gylee@enc.hanyang.ac.kr>
+//			      Jaewook Kwak <jwkwak@enc.hanyang.ac.kr>
+//
+// This file is part of Cosmos OpenSSD.
+//
+// Cosmos OpenSSD is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3, or (at your option)
+// any later version.
+//
+// Cosmos OpenSSD is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Cosmos OpenSSD; see the file COPYING.
+// If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////
+// Company: ENC Lab. <http://enc.hanyang.ac.kr>
+// Engineer: Gyeongyong Lee <gylee@enc.hanyang.ac.kr>
+//			 Jaewook Kwak <jwkwak@enc.hanyang.ac.kr>
+//
+// Project Name: Cosmos OpenSSD
+// Design Name: Greedy FTL
+// Module Name: Deduplication
+// File Name: dedup.c
+//
+// Version: v1.0.3
+//
+// Description:
+//   - inline deduplication of full pages, a page identical to a programmed page of the same die shares it
+//////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////
+// Revision History:
+//
+// * v1.0.3
+//   - candidate page is read through the I/O scheduler
+//
+// * v1.0.2
+//   - P2L entries are accessed by GetP2L() and SetP2L(), dedup entry of a physical sub-page is found by FindDedupId()
+//
+// * v1.0.1
+//   - container pages of compression are not shared, shared sub-page rewritten as zero is not validated
+//
+// * v1.0.0
+//   - First draft
+//////////////////////////////////////////////////////////////////////////////////
+
+#include "dedup.h"
+
+#include <assert.h>
+
+#include "lld.h"
+#include "pagemap.h"
+
+#include <string.h>
+
+void InitDedupMap()
+{
+#if DEDUP_ENABLE
+	dedupMap = (struct dedupArray*)(DEDUP_MAP_ADDR);
+
+	u32 dieNo, id;
+	for(dieNo=0 ; dieNo<DIE_NUM ; dieNo++)
+	{
+		for(id=0 ; id<DEDUP_ENTRY_NUM ; id++)
+		{
+			dedupMap->dedupEntry[dieNo][id].ppn = id + 1;
+			dedupMap->dedupEntry[dieNo][id].refCnt = 0;
+		}
+		dedupMap->freeHead[dieNo] = 0;
+		dedupMap->freeCnt[dieNo] = DEDUP_ENTRY_NUM;
+	}
+	dedupMap->hitCnt = 0;
+
+	xil_printf("[ ssd dedup map initialized. ]\r\n");
+#endif
+}
+
+// fingerprints are not saved, pages programmed after boot are found as duplicates
+void InitFingerprint()
+{
+#if DEDUP_ENABLE
+	fpIndex = (struct fpArray*)(FP_INDEX_ADDR);
+
+	memset(fpIndex, 0xff, sizeof(struct fpArray));
+#endif
+}
+
+// physical sub-page of a logical sub-page, through the dedup entry if it is shared
+u32 GetPpn(u32 dieNo, u32 dieLpn)
+{
+	u32 ppn = GetL2P(dieNo, dieLpn);
+
+	if(IS_DEDUP_ID(ppn))
+		return GetL2P(dieNo, ppn);
+
+	return ppn;
+}
+
+// 1 if the page is mapped to an identical page already programmed in the die, the caller programs it otherwise
+int DedupPage(u32 dieNo, u32 dieLpn, u32 bufAddr, u32 crc)
+{
+#if DEDUP_ENABLE
+	pageMap = (struct pmArray*)(PAGE_MAP_ADDR);
+	dedupMap = (struct dedupArray*)(DEDUP_MAP_ADDR);
+	fpIndex = (struct fpArray*)(FP_INDEX_ADDR);
+
+	struct fpEntry* fp = &fpIndex->fpEntry[dieNo][crc % DEDUP_INDEX_NUM];
+	u32 ppn = fp->ppn;
+	u32 sharer;
+	int i;
+
+	if((fp->crc != crc) || (ppn == 0xffffffff) || (dedupMap->freeCnt[dieNo] < SUB_PAGE_NUM_PER_PAGE))
+		return 0;
+
+	for(i=0 ; i<SUB_PAGE_NUM_PER_PAGE ; i++)
+		if(!IsValid(dieNo, ppn + i) || (GetP2L(dieNo, ppn + i) == CONTAINER_4BYTE))
+			return 0;
+
+	// CRC only nominates a candidate, the data in flash decides
+	WaitWayFree(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM);
+	IoRead(dieNo, IO_CLASS_HOST_WRITE, ppn / SUB_PAGE_NUM_PER_PAGE, DEDUP_BUFFER_ADDR);
+	WaitWayFree(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM);
+
+	if(!IsDataEqual(bufAddr, DEDUP_BUFFER_ADDR, PAGE_SIZE))
+		return 0;
+
+	// previous data is released first, it may be the candidate itself when the same data is written again
+	for(i=0 ; i<SUB_PAGE_NUM_PER_PAGE ; i++)
+		if(GetPpn(dieNo, dieLpn + i) != ppn + i)
+			UpdateMetaForOverwrite(dieNo, dieLpn + i);
+
+	for(i=0 ; i<SUB_PAGE_NUM_PER_PAGE ; i++)
+		if(!IsValid(dieNo, ppn + i))
+			return 0;
+
+	for(i=0 ; i<SUB_PAGE_NUM_PER_PAGE ; i++)
+	{
+		if(GetPpn(dieNo, dieLpn + i) == ppn + i)
+			continue;
+
+		// the first sharing moves the owner of the sub-page onto a dedup entry
+		sharer = GetP2L(dieNo, ppn + i);
+		if(!IS_DEDUP_ID(sharer))
+		{
+			u32 id = AllocDedupId(dieNo);
+
+			dedupMap->dedupEntry[dieNo][id].ppn = ppn + i;
+			dedupMap->dedupEntry[dieNo][id].refCnt = 1;
+			SetL2P(dieNo, sharer, DEDUP_ID_BASE + id);
+			SetP2L(dieNo, ppn + i, DEDUP_ID_BASE + id);
+			sharer = DEDUP_ID_BASE + id;
+		}
+
+		dedupMap->dedupEntry[dieNo][sharer - DEDUP_ID_BASE].refCnt++;
+		SetL2P(dieNo, dieLpn + i, sharer);
+	}
+
+	dedupMap->hitCnt++;
+
+	return 1;
+#else
+	return 0;
+#endif
+}
+
+// ppn is the first sub-page of the programmed page
+void InsertFingerprint(u32 dieNo, u32 ppn, u32 crc)
+{
+#if DEDUP_ENABLE
+	fpIndex = (struct fpArray*)(FP_INDEX_ADDR);
+
+	fpIndex->fpEntry[dieNo][crc % DEDUP_INDEX_NUM].crc = crc;
+	fpIndex->fpEntry[dieNo][crc % DEDUP_INDEX_NUM].ppn = ppn;
+#endif
+}
+
+u32 AllocDedupId(u32 dieNo)
+{
+#if DEDUP_ENABLE
+	dedupMap = (struct dedupArray*)(DEDUP_MAP_ADDR);
+
+	u32 id = dedupMap->freeHead[dieNo];
+
+	assert(dedupMap->freeCnt[dieNo] > 0);
+
+	dedupMap->freeHead[dieNo] = dedupMap->dedupEntry[dieNo][id].ppn;
+	dedupMap->freeCnt[dieNo]--;
+
+	return id;
+#else
+	return 0xffffffff;
+#endif
+}
+
+// the last sharer leaving invalidates the physical sub-page and frees the entry
+void ReleaseDedupRef(u32 dieNo, u32 id)
+{
+#if DEDUP_ENABLE
+	dedupMap = (struct dedupArray*)(DEDUP_MAP_ADDR);
+
+	if(--dedupMap->dedupEntry[dieNo][id].refCnt)
+		return;
+
+	UpdateMetaForOverwrite(dieNo, DEDUP_ID_BASE + id);
+
+	dedupMap->dedupEntry[dieNo][id].ppn = dedupMap->freeHead[dieNo];
+	dedupMap->freeHead[dieNo] = id;
+	dedupMap->freeCnt[dieNo]++;
+#endif
+}
+
+// dedup entry of a physical sub-page, 0xffffffff if it is not shared
+u32 FindDedupId(u32 dieNo, u32 ppn)
+{
+#if DEDUP_ENABLE
+	dedupMap = (struct dedupArray*)(DEDUP_MAP_ADDR);
+
+	u32 id;
+
+	for(id=0 ; id<DEDUP_ENTRY_NUM ; id++)
+		if(dedupMap->dedupEntry[dieNo][id].refCnt && (dedupMap->dedupEntry[dieNo][id].ppn == ppn))
+			return DEDUP_ID_BASE + id;
+#endif
+	return 0xffffffff;
+}
+
+// page maps keep the first owner of a shared sub-page, dedup map recovered with meta data tells its sharers
+void RecoverDedupMap()
+{
+#if DEDUP_ENABLE
+	pageMap = (struct pmArray*)(PAGE_MAP_ADDR);
+	dedupMap = (struct dedupArray*)(DEDUP_MAP_ADDR);
+
+	u32 dieNo, id, ppn;
+
+	for(dieNo=0 ; dieNo<DIE_NUM ; dieNo++)
+		for(id=0 ; id<DEDUP_ENTRY_NUM ; id++)
+			if(dedupMap->dedupEntry[dieNo][id].refCnt)
+			{
+				ppn = dedupMap->dedupEntry[dieNo][id].ppn;
+				if(ppn == ZERO_4BYTE)	// moved by wear leveling as a zero sub-page
+					continue;
+				SetP2L(dieNo, ppn, DEDUP_ID_BASE + id);
+				SetValid(dieNo, ppn);
+			}
+#endif
+}
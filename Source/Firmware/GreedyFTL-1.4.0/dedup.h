@@ -0,0 +1,103 @@
+//////////////////////////////////////////////////////////////////////////////////
+// dedup.h for Cosmos OpenSSD
+// Copyright (c) 2014 Hanyang University ENC Lab.
+// Contributed by Yong Ho Song <yhsong@enc.hanyang.ac.kr>
+//                Gyeongyong Lee <gylee@enc.hanyang.ac.kr>
+//			      Jaewook Kwak <jwkwak@enc.hanyang.ac.kr>
+//
+// This file is part of Cosmos OpenSSD.
+//
+// Cosmos OpenSSD is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3, or (at your option)
+// any later version.
+//
+// Cosmos OpenSSD is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Cosmos OpenSSD; see the file COPYING.
+// If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////
+// Company: ENC Lab. <http://enc.hanyang.ac.kr>
+// Engineer: Gyeongyong Lee <gylee@enc.hanyang.ac.kr>
+//			 Jaewook Kwak <jwkwak@enc.hanyang.ac.kr>
+//
+// Project Name: Cosmos OpenSSD
+// Design Name: Greedy FTL
+// Module Name: Deduplication
+// File Name: dedup.h
+//
+// Version: v1.0.1
+//
+// Description:
+//   - define shared physical sub-pages and fingerprint index of inline deduplication
+//////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////
+// Revision History:
+//
+// * v1.0.1
+//   - add FindDedupId()
+//
+// * v1.0.0
+//   - First draft
+//////////////////////////////////////////////////////////////////////////////////
+
+#ifndef DEDUP_H_
+#define DEDUP_H_
+
+#include "xil_types.h"
+#include "ftl.h"
+
+// L2P entry of a logical sub-page sharing its physical sub-page is DEDUP_ID_BASE + id of a dedup entry,
+// the dedup entry is reached by GetL2P() and SetL2P() with the same value, so GC and wear leveling move it once for all sharers
+#define DEDUP_ID_BASE	0x80000000
+#if DEDUP_ENABLE
+#define IS_DEDUP_ID(ppn)	(((ppn) >= DEDUP_ID_BASE) && ((ppn) < DEDUP_ID_BASE + DEDUP_ENTRY_NUM))
+#else
+#define IS_DEDUP_ID(ppn)	0
+#endif
+
+// physical sub-page shared by logical sub-pages, ppn links free entries while refCnt is 0
+struct dedupEntry {
+	u32 ppn;
+	u32 refCnt;
+};
+
+struct dedupArray {
+	struct dedupEntry dedupEntry[DIE_NUM][DEDUP_ENTRY_NUM];
+	u32 freeHead[DIE_NUM];
+	u32 freeCnt[DIE_NUM];
+	u32 hitCnt;	// pages not programmed as duplicates
+	u32 reserved;
+};
+
+// CRC32C of recently programmed pages and their first physical sub-page, direct mapped by CRC
+struct fpEntry {
+	u32 crc;
+	u32 ppn;
+};
+
+struct fpArray {
+	struct fpEntry fpEntry[DIE_NUM][DEDUP_INDEX_NUM];
+};
+
+struct dedupArray* dedupMap;
+struct fpArray* fpIndex;
+
+void InitDedupMap();
+void InitFingerprint();
+u32 GetPpn(u32 dieNo, u32 dieLpn);
+int DedupPage(u32 dieNo, u32 dieLpn, u32 bufAddr, u32 crc);
+void InsertFingerprint(u32 dieNo, u32 ppn, u32 crc);
+u32 AllocDedupId(u32 dieNo);
+void ReleaseDedupRef(u32 dieNo, u32 id);
+u32 FindDedupId(u32 dieNo, u32 ppn);
+void RecoverDedupMap();
+
+#endif /* DEDUP_H_ */
@@ -32,7 +32,7 @@
 // Module Name: Flash Translation Layer
 // File Name: ftl.c
 //
-// Version: v2.1.0
+// Version: v2.12.1
 //
 // Description:
 //   - initial NAND flash memory reset
@@ -42,6 +42,42 @@
 //////////////////////////////////////////////////////////////////////////////////
 // Revision History:
 //
+// * v2.12.1
+//   - initialize I/O scheduler first
+//
+// * v2.12.0
+//   - add over-provisioning setting, hidden logical pages are unmapped at recovery
+//
+// * v2.11.0
+//   - add background GC initialization
+//
+// * v2.10.0
+//   - initialize compression before page map is recovered
+//
+// * v2.9.0
+//   - initialize dedup map and fingerprint index
+//
+// * v2.8.0
+//   - add data kernel initialization
+//
+// * v2.7.0
+//   - add wear leveling initialization
+//
+// * v2.6.0
+//   - add SMART counter initialization
+//
+// * v2.5.0
+//   - add write buffer pool initialization
+//
+// * v2.4.0
+//   - add read-ahead buffer initialization
+//
+// * v2.3.0
+//   - add L2P map and translation block initialization
+//
+// * v2.2.0
+//   - add packing buffer initialization
+//
 // * v2.1.0
 //	 - meta data recovery
 //   - add CI table initialization
@@ -88,20 +124,43 @@ void InitFtlMapTable()
 {
 	int MetadataExist;
 
+	InitDataKernel();
+	InitIoSched();
 	MetadataExist = CheckMetadata();
 	if(MetadataExist)
 	{
 		RecoverMetadata();
+		InitMapCache();
+		InitCompress();
 		RecoverPageMap();
+		InitFingerprint();
+		InitWriteBuf();
+		InitPackBuf();
+		InitReadAhead();
+		InitWearLevel();
+		RecoverConfig();
+		InitGcSched();
 	}
 	else
 	{
 		InitPageMap();
 		InitBlockMap();
+		InitTransBlock();
+		InitMapCache();
 		InitDieBlock();
 
 		InitGcMap();
 		InitCiMap();
+		InitSmart();
+		InitDedupMap();
+		InitFingerprint();
+		InitCompress();
+		InitWriteBuf();
+		InitPackBuf();
+		InitReadAhead();
+		InitWearLevel();
+		InitConfig();
+		InitGcSched();
 	}
 }
 
@@ -32,7 +32,7 @@
 // Module Name: Flash Translation Layer
 // File Name: ftl.h
 //
-// Version: v1.0.2
+// Version: v1.12.0
 //
 // Description:
 //   - define NAND flash memory and SSD parameters
@@ -41,6 +41,48 @@
 //////////////////////////////////////////////////////////////////////////////////
 // Revision History:
 //
+// * v1.12.0
+//   - add parameters of I/O scheduler
+//
+// * v1.11.2
+//   - P2L table is not resident when the mapping table is cached
+//
+// * v1.11.1
+//   - page mapping is the default granularity, sub-page mapping doubles map tables in DRAM
+//
+// * v1.11.0
+//   - add parameters of over-provisioning
+//
+// * v1.10.0
+//   - GC share of host writes is paced by free blocks instead of a fixed number of pages
+//
+// * v1.9.0
+//   - add parameters of background GC
+//
+// * v1.8.0
+//   - add parameters of program/erase suspend
+//
+// * v1.7.0
+//   - add parameters of inline compression
+//
+// * v1.6.0
+//   - add parameters of inline deduplication
+//
+// * v1.5.0
+//   - add parameters of write streams
+//
+// * v1.4.0
+//   - add parameter of wear leveling
+//
+// * v1.3.0
+//   - add parameters of read-ahead
+//
+// * v1.2.0
+//   - add parameters of cached mapping table
+//
+// * v1.1.0
+//   - add sub-page constants for configurable mapping granularity
+//
 // * v1.0.2
 //   - add constant to calculate ssd size
 //
@@ -67,16 +109,91 @@
 
 #define	SECTOR_NUM_PER_PAGE		(PAGE_SIZE / SECTOR_SIZE_FTL)
 
+// mapping granularity, 1: page (8KB) mapping, 2: sub-page (4KB) mapping
+// P2L and L2P tables take 4 bytes per sub-page each, 128MB in total with 1 and 256MB with 2
+#define	SUB_PAGE_NUM_PER_PAGE	1
+#define	SUB_PAGE_SIZE			(PAGE_SIZE / SUB_PAGE_NUM_PER_PAGE)
+#define	SECTOR_NUM_PER_SUB_PAGE	(SECTOR_NUM_PER_PAGE / SUB_PAGE_NUM_PER_PAGE)
+
 #define	PAGE_NUM_PER_DIE		(PAGE_NUM_PER_BLOCK * BLOCK_NUM_PER_DIE)
 #define	PAGE_NUM_PER_CHANNEL	(PAGE_NUM_PER_DIE * WAY_NUM)
 #define	PAGE_NUM_PER_SSD		(PAGE_NUM_PER_CHANNEL * CHANNEL_NUM)
 
+#define	SUB_PAGE_NUM_PER_BLOCK	(PAGE_NUM_PER_BLOCK * SUB_PAGE_NUM_PER_PAGE)
+#define	SUB_PAGE_NUM_PER_DIE	(PAGE_NUM_PER_DIE * SUB_PAGE_NUM_PER_PAGE)
+#define	SUB_PAGE_NUM_PER_SSD	(PAGE_NUM_PER_SSD * SUB_PAGE_NUM_PER_PAGE)
+
 #define	BLOCK_NUM_PER_CHANNEL	(BLOCK_NUM_PER_DIE * WAY_NUM)
 #define	BLOCK_NUM_PER_SSD		(BLOCK_NUM_PER_CHANNEL * CHANNEL_NUM)
 
+// cached mapping table, 0: whole L2P and P2L tables in DRAM, 1: L2P table is demand-paged from translation pages in flash
+// and only open blocks keep P2L entries in DRAM, closed blocks give them from their page map pages
+#define	MAP_CACHE_ENABLE		0
+#define	MAP_CACHE_SLOT_NUM		4096	// translation pages cached in DRAM (32MB)
+
+#define	TRANS_ENTRY_NUM_PER_PAGE	(PAGE_SIZE / 4)
+#define	TRANS_PAGE_NUM_PER_DIE		((SUB_PAGE_NUM_PER_DIE + TRANS_ENTRY_NUM_PER_PAGE - 1) / TRANS_ENTRY_NUM_PER_PAGE)
+// translation pages are logged in twice the blocks they need plus a spare block for compaction
+#define	TRANS_BLOCK_NUM_PER_DIE		(2 * ((TRANS_PAGE_NUM_PER_DIE + PAGE_NUM_PER_BLOCK - 1) / PAGE_NUM_PER_BLOCK) + 1)
+
+// read-ahead of sequential read streams, 0 pages disables prefetch
+#define	READ_AHEAD_PAGE_NUM		(2 * DIE_NUM)	// pages prefetched ahead of a stream
+#define	READ_AHEAD_SLOT_NUM		(4 * DIE_NUM)	// pages held in read-ahead buffer, multiple of DIE_NUM
+#define	READ_AHEAD_TRIGGER		2	// consecutive sequential reads to detect a stream
+
+// static wear leveling moves cold data when erase counts of a die spread wider than this
+#define	WEAR_LEVEL_THRESHOLD	100
+
+// write streams of each die, each has its own open block
+#define	STREAM_HOT				0	// host data overwritten soon after its last write
+#define	STREAM_COLD				1	// host data written for the first time or after a long time
+#define	STREAM_GC				2	// data migrated by GC
+#define	STREAM_HOST_NUM			2	// host streams come first
+#define	STREAM_NUM				3
+// overwrite of data programmed within this many pages of the die is hot
+#define	HOT_DATA_AGE			(PAGE_NUM_PER_DIE / 8)
+
+// inline deduplication, 0: disabled, 1: a full page identical to a programmed page of the same die is not programmed
+#define	DEDUP_ENABLE			0
+#define	DEDUP_ENTRY_NUM			4096	// shared physical sub-pages of a die, saved with meta data
+#define	DEDUP_INDEX_NUM			16384	// fingerprints of programmed pages of a die
+
+// inline compression, 0: disabled, 1: full pages compressed to half a page or less are packed into container pages
+#define	COMP_ENABLE				0
+#define	COMP_SLOT_NUM			8	// compressed pages in a container page
+
+// program/erase suspend, 0: disabled, 1: a host read to a die busy with a program or erase suspends it
+// NAND and channel controller must support suspend and resume commands
+#define	SUSPEND_ENABLE			0
+#define	SUSPEND_MAX_NUM			4	// suspends of a program or erase, bounds the delay of the operation
+
+// background GC, a die with fewer free blocks than this migrates a victim in steps while no request waits
+// and in pace with host writes, so that host writes rarely wait for a whole victim, 0 disables it
+#define	GC_BG_FREE_BLOCK_NUM	8
+#define	GC_BG_MIN_INVALID		(SUB_PAGE_NUM_PER_BLOCK * 3 / 4)	// invalid sub-pages of a victim worth migrating early
+#define	GC_IDLE_STEP_PAGE_NUM	1	// valid pages migrated per poll of an idle host interface, bounds the delay of a request
+#define	GC_PACE_FREE_BLOCK_NUM	2	// free blocks of a die at or under which host writes take any victim and pay for it
+#define	GC_BG_OP_DIV			4	// background GC keeps a block more free for every this many over-provisioned blocks of a die
+
+// per-die dispatch of NAND commands by class, a host write program finding its die busy is queued and the request goes on
+// host reads go ahead of queued programs, GC programs and host write programs share a die while both wait
+#define	IO_WRITE_QUEUE_DEPTH	4	// queued host write programs of a die
+#define	IO_WRITE_DEADLINE_US	5000	// a queued program stops waiting for read requests and goes ahead of GC and meta data after this
+#define	IO_GC_SHARE				50	// percent of programs of a die GC takes while host write programs are queued on it
+
+// over-provisioning, percent of blocks of each die left out of the exported capacity to lower write amplification
+// taken at format, a vendor command changes it from the next boot, data beyond a shrunk capacity is discarded
+#define	OVER_PROVISION_PERCENT	0
+#define	OVER_PROVISION_MAX		50
+
 #define SSD_SIZE				(BLOCK_NUM_PER_SSD * BLOCK_SIZE_MB) //MB
-#define FREE_BLOCK_SIZE			(DIE_NUM * BLOCK_SIZE_MB)	//MB
+#define FREE_BLOCK_SIZE			(DIE_NUM * STREAM_NUM * BLOCK_SIZE_MB)	//MB, GC reserve and open blocks of streams other than hot
 #define METADATA_BLOCK_SIZE		(1 * BLOCK_SIZE_MB)	//MB
+#if MAP_CACHE_ENABLE
+#define TRANS_BLOCK_SIZE		(DIE_NUM * TRANS_BLOCK_NUM_PER_DIE * BLOCK_SIZE_MB)	//MB
+#else
+#define TRANS_BLOCK_SIZE		0
+#endif
 
 void InitNandReset();
 void InitFtlMapTable();
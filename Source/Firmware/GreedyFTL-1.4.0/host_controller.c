@@ -30,7 +30,7 @@
 // Design Name: Host Controller
 // File Name: host_controller.c
 //
-// Version: v1.1.0
+// Version: v1.6.5
 //
 // Description:
 //   - Provides host interface (GetRequestCmd, DmaDeviceToHost, CompleteCmd, ...)
@@ -39,6 +39,39 @@
 //////////////////////////////////////////////////////////////////////////////////
 // Revision History:
 //
+// * v1.6.5
+//   - queued host write programs are issued while waiting for a request
+//
+// * v1.6.4
+//   - completion ring restarts whenever host programs its base address, not only at shutdown
+//
+// * v1.6.3
+//   - window of a descriptor chain starts initialized
+//
+// * v1.6.2
+//   - background GC runs a step while waiting for a request
+//
+// * v1.6.1
+//   - static wear leveling runs while waiting for a request
+//
+// * v1.6.0
+//   - stamp fetch, data DMA and completion of each command
+//
+// * v1.5.0
+//   - completions are staged in a ring with a phase bit and posted together by a single DMA
+//
+// * v1.4.0
+//   - AXI BAR translation is re-programmed only when the host address leaves the cached window
+//
+// * v1.3.0
+//   - scatter regions in an AXI BAR window are transferred by a descriptor chain with a single kick
+//
+// * v1.2.1
+//   - device address is given to each partial transfer so that host data can land in any buffer
+//
+// * v1.2.0
+//   - data DMA can be continued part by part from a cursor to overlap with NAND operations
+//
 // * v1.1.0
 //   - Support shutdown command (not ATA command)
 //   - Improve code readability
@@ -59,6 +92,9 @@
 #include "mem_map.h"
 #include "host_controller.h"
 #include "identify.h"
+#include "stats.h"
+#include "wear_level.h"
+#include "pagemap.h"
 
 #ifndef HOST_CONTROLLER_C_
 #define HOST_CONTROLLER_C_
@@ -68,9 +104,26 @@ XAxiPcie_BarAddr barAddrPtr;
 XAxiPcie_BarAddr barAddrPtrForTest;
 XAxiCdma devCdma;
 
+// host address window currently translated by each AXI BAR
+XAxiPcie_BarAddr barWindow[BAR_WINDOW_NUM];
+u32 barWindowValid[BAR_WINDOW_NUM];
+
+#if (BAR_WINDOW_NUM == 3)
+const u32 barWindowBaseAddr[BAR_WINDOW_NUM] = {XPAR_AXIPCIE_0_AXIBAR_0, XPAR_AXIPCIE_0_AXIBAR_1, XPAR_AXIPCIE_0_AXIBAR_2};
+#else
+const u32 barWindowBaseAddr[BAR_WINDOW_NUM] = {XPAR_AXIPCIE_0_AXIBAR_0};
+#endif
+
 P_HOST_SCATTER_REGION pHostScaterRegion = (P_HOST_SCATTER_REGION)HOST_SCATTER_REGION_BASE_ADDR;
 P_COMPLETION_IO pCompletionIO =  (P_COMPLETION_IO)COMPLETION_IO_BASE_ADDR;
 
+// completion ring, entries from cplPosted to cplTail are staged but not posted yet
+u32 cplTail;
+u32 cplPosted;
+u32 cplPhase;
+u32 cplReqCount;
+XAxiPcie_BarAddr cplBase;	// host address of the ring taken from controller registers
+
 u32 CheckRequest()
 {
 	u32 reqStart;
@@ -81,6 +134,18 @@ u32 CheckRequest()
 	do{
 		reqStart = Xil_In32(CONFIG_SPACE_REQUEST_START);
 		shutdown = Xil_In32(CONFIG_SPACE_SHUTDOWN);
+
+		//base address is written before a request, so it is checked after the request is seen
+		CheckCompletionBase();
+
+		//no request to serve first, post staged completions, then run background work of FTL
+		if((reqStart == 0) && (shutdown == 0))
+		{
+			PostCompletion();
+			IoDispatch();
+			GcIdle();
+			WearLevelIdle();
+		}
 	}while((reqStart == 0) && (shutdown == 0));
 
 	if(shutdown == 1)
@@ -98,28 +163,7 @@ u32 GetRequestCmd(P_HOST_CMD hostCmd)
 	u32 hostAddr, isDmaError;
 	P_REQUEST_IO reqInfoAddr = (P_REQUEST_IO)(REQUEST_IO_BASE_ADDR);
 
-	barAddrPtr.UpperAddr = Xil_In32(CONFIG_SPACE_REQUEST_BASE_ADDR_U);
-	barAddrPtr.LowerAddr = Xil_In32(CONFIG_SPACE_REQUEST_BASE_ADDR_L);
-	//DebugPrint("BarAddrPtr.UpperAddr = 0x%x\n\r", BarAddrPtr.UpperAddr);
-	//DebugPrint("BarAddrPtr.LowerAddr = 0x%x\n\r", BarAddrPtr.LowerAddr);
-	while(XAxiCdma_IsBusy(&devCdma))
-	{
-	}
-	while(1)
-	{
-		XAxiPcie_SetLocalBusBar2PcieBar(&devPcie, 0x00, &barAddrPtr);
-		XAxiPcie_GetLocalBusBar2PcieBar(&devPcie, 0x00, &barAddrPtrForTest);
-		if(barAddrPtr.LowerAddr == barAddrPtrForTest.LowerAddr)
-		{
-			if(barAddrPtr.UpperAddr == barAddrPtrForTest.UpperAddr)
-			{
-				break;
-			}
-		}
-	}
-
-	hostAddr = Xil_In32(CONFIG_SPACE_REQUEST_BASE_ADDR_L) & DMA_ADDR_MASK;
-	hostAddr = XPAR_AXIPCIE_0_AXIBAR_0 + hostAddr;
+	hostAddr = SetBarWindow(BAR_WINDOW_REQUEST, Xil_In32(CONFIG_SPACE_REQUEST_BASE_ADDR_U), Xil_In32(CONFIG_SPACE_REQUEST_BASE_ADDR_L));
 
 	//wait until cdma is idle
 	while(XAxiCdma_IsBusy(&devCdma))
@@ -154,6 +198,8 @@ u32 GetRequestCmd(P_HOST_CMD hostCmd)
 	DebugPrint("HostScatterAddrL = 0x%x\n\r", hostCmd->reqInfo.HostScatterAddrL);
 	DebugPrint("HostScatterLen = 0x%x\n\r\n\r", hostCmd->reqInfo.HostScatterLen);
 
+	StatsCmdStart(hostCmd->reqInfo.Cmd);
+
 	return TRUE;
 }
 
@@ -162,33 +208,14 @@ u32 GetHostScatterRegion(P_HOST_CMD hostCmd)
 	u32 hostAddr;
 	u32 isDmaError;
 
-	//get address of HOST_SCATTER_REGION array from command
-	barAddrPtr.UpperAddr = hostCmd->reqInfo.HostScatterAddrU;
-	barAddrPtr.LowerAddr = hostCmd->reqInfo.HostScatterAddrL;
+	//set host address of HOST_SCATTER_REGION array from command
+	hostAddr = SetBarWindow(BAR_WINDOW_DATA, hostCmd->reqInfo.HostScatterAddrU, hostCmd->reqInfo.HostScatterAddrL);
 
 	//check DMA module is busy
 	while(XAxiCdma_IsBusy(&devCdma))
 	{
 	}
 
-	//set host address register of DMA module
-	while(1)
-	{
-		XAxiPcie_SetLocalBusBar2PcieBar(&devPcie, 0x00, &barAddrPtr);
-		XAxiPcie_GetLocalBusBar2PcieBar(&devPcie, 0x00, &barAddrPtrForTest);
-		if(barAddrPtr.LowerAddr == barAddrPtrForTest.LowerAddr)
-		{
-			if(barAddrPtr.UpperAddr == barAddrPtrForTest.UpperAddr)
-			{
-				break;
-			}
-		}
-	}
-
-	//set host address
-	hostAddr = hostCmd->reqInfo.HostScatterAddrL & DMA_ADDR_MASK;
-	hostAddr = XPAR_AXIPCIE_0_AXIBAR_0 + hostAddr;
-
 	//get HOST_SCATTER_REGION array
 	do
 	{
@@ -209,95 +236,30 @@ u32 GetHostScatterRegion(P_HOST_CMD hostCmd)
 	return 0;
 }
 
-void DmaDeviceToHost(P_HOST_CMD hostCmd, u32 deviceAddr, u32 reqSize, u32 scatterLength)
+void InitBarWindow()
 {
-	u32 hostAddr;
-	u32 flag;
-	u32 deviceAddrOffset;
-	u32 curScatterRegionNum;
-	u32 curDmaSize;
-	u32 remainedCurrentScatterRegionSize;
-	u32 acc;
-	u32 isDmaError;
+	u32 window;
 
-	//get HOST_SCATTER_REGION array from HOST
-	GetHostScatterRegion(hostCmd);
-
-	/////////////////////////////////////////////////////////////////////
-	//start data dma
-	/////////////////////////////////////////////////////////////////////
-
-	flag = 0;
-	deviceAddrOffset = 0;
-	curScatterRegionNum = 0;
-	acc = 0;
+	for(window = 0; window < BAR_WINDOW_NUM; window++)
+		barWindowValid[window] = 0;
+}
 
-	while(curScatterRegionNum < scatterLength)
+u32 SetBarWindow(u32 window, u32 hostAddrU, u32 hostAddrL)
+{
+	//re-program the AXI BAR only when the host address is out of the window it translates
+	if(!barWindowValid[window] || (barWindow[window].UpperAddr != hostAddrU) || (barWindow[window].LowerAddr != (hostAddrL & ~DMA_ADDR_MASK)))
 	{
-		remainedCurrentScatterRegionSize = pHostScaterRegion[curScatterRegionNum].Size - acc;
-		DebugPrint("remainedCurrentScatterRegionSize = 0x%x\n\r", remainedCurrentScatterRegionSize);
-		if(flag == 0)//normal transfer
-		{
-			DebugPrint("flag 0\n\r");
-			//set host address
-			barAddrPtr.UpperAddr = pHostScaterRegion[curScatterRegionNum].DmaAddrU;
-			barAddrPtr.LowerAddr = pHostScaterRegion[curScatterRegionNum].DmaAddrL;
-
-			hostAddr = barAddrPtr.LowerAddr & DMA_ADDR_MASK;
-			hostAddr = XPAR_AXIPCIE_0_AXIBAR_0 + hostAddr;
-
-			//if blabla~
-			if(((XPAR_AXIPCIE_0_AXIBAR_HIGHADDR_0 + 1) - hostAddr) < remainedCurrentScatterRegionSize)//
-			{
-				flag = 1;
-				curDmaSize = (XPAR_AXIPCIE_0_AXIBAR_HIGHADDR_0 + 1) - hostAddr;
-				acc += curDmaSize;
-			}
-			//if blabla~
-			else
-			{
-				curDmaSize = remainedCurrentScatterRegionSize;
-				curScatterRegionNum += 1;
-			}
-		}
-		else//partial transfer
-		{
-			DebugPrint("flag 1\n\r");
-			//set host address
-			if((barAddrPtr.LowerAddr + curDmaSize) < barAddrPtr.LowerAddr)
-			{
-				barAddrPtr.UpperAddr += 1;
-			}
-			barAddrPtr.LowerAddr += curDmaSize;
-
-			hostAddr = barAddrPtr.LowerAddr & DMA_ADDR_MASK;
-			hostAddr = XPAR_AXIPCIE_0_AXIBAR_0 + hostAddr;
-
-			//if blabla~
-			if(((XPAR_AXIPCIE_0_AXIBAR_HIGHADDR_0 + 1) - hostAddr) < remainedCurrentScatterRegionSize)//
-			{
-				curDmaSize = (XPAR_AXIPCIE_0_AXIBAR_HIGHADDR_0 + 1) - hostAddr;
-				acc += curDmaSize;
-			}
-			//if blabla~
-			else//last
-			{
-				curDmaSize = remainedCurrentScatterRegionSize;
-				flag = 0;
-				acc = 0;
-				curScatterRegionNum += 1;
-			}
-		}
+		barAddrPtr.UpperAddr = hostAddrU;
+		barAddrPtr.LowerAddr = hostAddrL & ~DMA_ADDR_MASK;
 
-		DebugPrint("dmaAddrU = 0x%x\n\r", barAddrPtr.UpperAddr);
-		DebugPrint("dmaAddrL = 0x%x\n\r", barAddrPtr.LowerAddr);
+		//a transfer in flight may still use the window
 		while(XAxiCdma_IsBusy(&devCdma))
 		{
 		}
 		while(1)
 		{
-			XAxiPcie_SetLocalBusBar2PcieBar(&devPcie, 0x00, &barAddrPtr);
-			XAxiPcie_GetLocalBusBar2PcieBar(&devPcie, 0x00, &barAddrPtrForTest);
+			XAxiPcie_SetLocalBusBar2PcieBar(&devPcie, window, &barAddrPtr);
+			XAxiPcie_GetLocalBusBar2PcieBar(&devPcie, window, &barAddrPtrForTest);
 			if(barAddrPtr.LowerAddr == barAddrPtrForTest.LowerAddr)
 			{
 				if(barAddrPtr.UpperAddr == barAddrPtrForTest.UpperAddr)
@@ -307,216 +269,291 @@ void DmaDeviceToHost(P_HOST_CMD hostCmd, u32 deviceAddr, u32 reqSize, u32 scatte
 			}
 		}
 
-		while(XAxiCdma_IsBusy(&devCdma))
-		{
-		}
+		barWindow[window] = barAddrPtr;
+		barWindowValid[window] = 1;
+	}
 
-		do
-		{
-			//if(hostCmd->reqInfo.Cmd)
-			isDmaError = XAxiCdma_SimpleTransfer(&devCdma, deviceAddr + deviceAddrOffset, hostAddr,
-													curDmaSize, NULL, NULL);
-			if(isDmaError)
-				DebugPrint("%s, %d\n\r", __FUNCTION__, __LINE__);
-		}
-		while(isDmaError);
+	return barWindowBaseAddr[window] + (hostAddrL & DMA_ADDR_MASK);
+}
 
-		while(XAxiCdma_IsBusy(&devCdma))
-		{
-		}
-		deviceAddrOffset += curDmaSize;
-	}
+void DmaStart(P_HOST_CMD hostCmd, P_DMA_CURSOR dmaCursor)
+{
+	//get HOST_SCATTER_REGION array from HOST
+	GetHostScatterRegion(hostCmd);
 
-	/*for(tmp = 0; tmp < reqSize; tmp++)
-	{
-		if(((*(u8 *)(deviceAddr + tmp)) < (u8)65) || ((*(u8 *)(deviceAddr + tmp)) > (u8)80))
-		{
-			DebugPrint("err:%c\n\r", Xil_In8(deviceAddr + tmp));
-		}
-	}*/
-	DebugPrint("%x\n\r", Xil_In32(deviceAddr));
+	dmaCursor->curScatterRegionNum = 0;
+	dmaCursor->acc = 0;
 }
 
-void DmaHostToDevice(P_HOST_CMD hostCmd, u32 deviceAddr, u32 reqSize, u32 scatterLength)
+void InitCdmaBdRing()
 {
-	u32 hostAddr;
-	u32 flag;
-	u32 deviceAddrOffset;
-	u32 curScatterRegionNum;
-	u32 curDmaSize;
+	int bdCnt;
+
+	bdCnt = XAxiCdma_BdRingCntCalc(XAXICDMA_BD_MINIMUM_ALIGNMENT, CDMA_BD_NUM * sizeof(XAxiCdma_Bd), CDMA_BD_RING_BASE_ADDR);
+	if(XAxiCdma_BdRingCreate(&devCdma, CDMA_BD_RING_BASE_ADDR, CDMA_BD_RING_BASE_ADDR, XAXICDMA_BD_MINIMUM_ALIGNMENT, bdCnt) != XST_SUCCESS)
+		xil_printf("CDMA descriptor ring creation failed\r\n");
+}
+
+void DmaTransfer(P_HOST_CMD hostCmd, P_DMA_CURSOR dmaCursor, u32 deviceAddr, u32 size, u32 direction)
+{
+	XAxiPcie_BarAddr dmaAddr;
+	XAxiPcie_BarAddr chainAddr = {0, 0};	// set by the first descriptor of each chain
+	XAxiCdma_Bd* bdPtr;
+	XAxiCdma_Bd* curBdPtr;
+	u32 hostAddr[CDMA_BD_NUM];
+	u32 windowAddr;
+	u32 bdDeviceAddr[CDMA_BD_NUM];
+	u32 curDmaSize[CDMA_BD_NUM];
 	u32 remainedCurrentScatterRegionSize;
-	u32 acc;
 	u32 isDmaError;
-
-	//get HOST_SCATTER_REGION array from HOST
-	GetHostScatterRegion(hostCmd);
+	int bdNum, bdIdx, doneCnt, cnt;
 
 	/////////////////////////////////////////////////////////////////////
-	//start data dma
+	//continue data dma from the cursor
 	/////////////////////////////////////////////////////////////////////
 
-	flag = 0;
-	deviceAddrOffset = 0;
-	curScatterRegionNum = 0;
-	acc = 0;
-
-	while(curScatterRegionNum < scatterLength)
+	while((size > 0) && (dmaCursor->curScatterRegionNum < hostCmd->reqInfo.HostScatterNum))
 	{
-		remainedCurrentScatterRegionSize = pHostScaterRegion[curScatterRegionNum].Size - acc;
-		DebugPrint("remainedCurrentScatterRegionSize = 0x%x\n\r", remainedCurrentScatterRegionSize);
-		if(flag == 0)//normal transfer
+		//gather scatter regions lying in the same AXI BAR window into a descriptor chain
+		bdNum = 0;
+		while((size > 0) && (dmaCursor->curScatterRegionNum < hostCmd->reqInfo.HostScatterNum) && (bdNum < CDMA_BD_NUM))
 		{
-			DebugPrint("flag 0\n\r");
-			//set host address
-			barAddrPtr.UpperAddr = pHostScaterRegion[curScatterRegionNum].DmaAddrU;
-			barAddrPtr.LowerAddr = pHostScaterRegion[curScatterRegionNum].DmaAddrL;
+			remainedCurrentScatterRegionSize = pHostScaterRegion[dmaCursor->curScatterRegionNum].Size - dmaCursor->acc;
+			DebugPrint("remainedCurrentScatterRegionSize = 0x%x\n\r", remainedCurrentScatterRegionSize);
 
-			hostAddr = barAddrPtr.LowerAddr & DMA_ADDR_MASK;
-			hostAddr = XPAR_AXIPCIE_0_AXIBAR_0 + hostAddr;
-
-			//if blabla~
-			if(((XPAR_AXIPCIE_0_AXIBAR_HIGHADDR_0 + 1) - hostAddr) < remainedCurrentScatterRegionSize)//
+			//host address, skipping the part of the scatter region already transferred
+			dmaAddr.UpperAddr = pHostScaterRegion[dmaCursor->curScatterRegionNum].DmaAddrU;
+			dmaAddr.LowerAddr = pHostScaterRegion[dmaCursor->curScatterRegionNum].DmaAddrL + dmaCursor->acc;
+			if(dmaAddr.LowerAddr < pHostScaterRegion[dmaCursor->curScatterRegionNum].DmaAddrL)
 			{
-				flag = 1;
-				curDmaSize = (XPAR_AXIPCIE_0_AXIBAR_HIGHADDR_0 + 1) - hostAddr;
-				acc += curDmaSize;
+				dmaAddr.UpperAddr += 1;
 			}
-			//if blabla~
-			else
+
+			if(bdNum == 0)
 			{
-				curDmaSize = remainedCurrentScatterRegionSize;
-				curScatterRegionNum += 1;
+				chainAddr = dmaAddr;
 			}
-		}
-		else//partial transfer
-		{
-			DebugPrint("flag 1\n\r");
-			//set host address
-			if((barAddrPtr.LowerAddr + curDmaSize) < barAddrPtr.LowerAddr)
+			else if((dmaAddr.UpperAddr != chainAddr.UpperAddr) || ((dmaAddr.LowerAddr & ~DMA_ADDR_MASK) != (chainAddr.LowerAddr & ~DMA_ADDR_MASK)))
 			{
-				barAddrPtr.UpperAddr += 1;
+				//out of the window, transferred by the next chain
+				break;
 			}
-			barAddrPtr.LowerAddr += curDmaSize;
 
-			hostAddr = barAddrPtr.LowerAddr & DMA_ADDR_MASK;
-			hostAddr = XPAR_AXIPCIE_0_AXIBAR_0 + hostAddr;
+			//offset in the window, AXI address is given after the window is set
+			hostAddr[bdNum] = dmaAddr.LowerAddr & DMA_ADDR_MASK;
 
-			//if blabla~
-			if(((XPAR_AXIPCIE_0_AXIBAR_HIGHADDR_0 + 1) - hostAddr) < remainedCurrentScatterRegionSize)//
+			//transfer is split at the end of AXI BAR window and at the requested size
+			curDmaSize[bdNum] = remainedCurrentScatterRegionSize;
+			if((DMA_WINDOW_SIZE - hostAddr[bdNum]) < curDmaSize[bdNum])
 			{
-				curDmaSize = (XPAR_AXIPCIE_0_AXIBAR_HIGHADDR_0 + 1) - hostAddr;
-				acc += curDmaSize;
+				curDmaSize[bdNum] = DMA_WINDOW_SIZE - hostAddr[bdNum];
 			}
-			//if blabla~
-			else//last
+			if(size < curDmaSize[bdNum])
+			{
+				curDmaSize[bdNum] = size;
+			}
+			bdDeviceAddr[bdNum] = deviceAddr;
+
+			deviceAddr += curDmaSize[bdNum];
+			dmaCursor->acc += curDmaSize[bdNum];
+			size -= curDmaSize[bdNum];
+			if(dmaCursor->acc == pHostScaterRegion[dmaCursor->curScatterRegionNum].Size)
 			{
-				curDmaSize = remainedCurrentScatterRegionSize;
-				flag = 0;
-				acc = 0;
-				curScatterRegionNum += 1;
+				dmaCursor->curScatterRegionNum += 1;
+				dmaCursor->acc = 0;
 			}
+			bdNum++;
 		}
 
-		DebugPrint("dmaAddrU = 0x%x\n\r", barAddrPtr.UpperAddr);
-		DebugPrint("dmaAddrL = 0x%x\n\r", barAddrPtr.LowerAddr);
+		DebugPrint("dmaAddrU = 0x%x\n\r", chainAddr.UpperAddr);
+		DebugPrint("dmaAddrL = 0x%x\n\r", chainAddr.LowerAddr);
+		windowAddr = SetBarWindow(BAR_WINDOW_DATA, chainAddr.UpperAddr, chainAddr.LowerAddr & ~DMA_ADDR_MASK);
+		for(bdIdx = 0; bdIdx < bdNum; bdIdx++)
+			hostAddr[bdIdx] += windowAddr;
+
 		while(XAxiCdma_IsBusy(&devCdma))
 		{
 		}
-		while(1)
+
+		if(bdNum == 1)
 		{
-			XAxiPcie_SetLocalBusBar2PcieBar(&devPcie, 0x00, &barAddrPtr);
-			XAxiPcie_GetLocalBusBar2PcieBar(&devPcie, 0x00, &barAddrPtrForTest);
-			if(barAddrPtr.LowerAddr == barAddrPtrForTest.LowerAddr)
+			//a single region needs no descriptor
+			do
+			{
+				if(direction == DMA_DEVICE_TO_HOST)
+					isDmaError = XAxiCdma_SimpleTransfer(&devCdma, bdDeviceAddr[0], hostAddr[0], curDmaSize[0], NULL, NULL);
+				else
+					isDmaError = XAxiCdma_SimpleTransfer(&devCdma, hostAddr[0], bdDeviceAddr[0], curDmaSize[0], NULL, NULL);
+				if(isDmaError)
+					DebugPrint("%s, %d\n\r", __FUNCTION__, __LINE__);
+			}
+			while(isDmaError);
+
+			while(XAxiCdma_IsBusy(&devCdma))
 			{
-				if(barAddrPtr.UpperAddr == barAddrPtrForTest.UpperAddr)
-				{
-					break;
-				}
 			}
+
+			continue;
 		}
 
-		while(XAxiCdma_IsBusy(&devCdma))
+		//build descriptor chain and kick it at once
+		while(XAxiCdma_SwitchMode(&devCdma, XAXICDMA_SG_MODE) != XST_SUCCESS)
+		{
+		}
+		while(XAxiCdma_BdRingAlloc(&devCdma, bdNum, &bdPtr) != XST_SUCCESS)
 		{
+			DebugPrint("%s, %d\n\r", __FUNCTION__, __LINE__);
 		}
+
+		curBdPtr = bdPtr;
+		for(bdIdx = 0; bdIdx < bdNum; bdIdx++)
+		{
+			if(direction == DMA_DEVICE_TO_HOST)
+			{
+				XAxiCdma_BdSetSrcBufAddr(curBdPtr, bdDeviceAddr[bdIdx]);
+				XAxiCdma_BdSetDstBufAddr(curBdPtr, hostAddr[bdIdx]);
+			}
+			else
+			{
+				XAxiCdma_BdSetSrcBufAddr(curBdPtr, hostAddr[bdIdx]);
+				XAxiCdma_BdSetDstBufAddr(curBdPtr, bdDeviceAddr[bdIdx]);
+			}
+			XAxiCdma_BdSetLength(curBdPtr, curDmaSize[bdIdx]);
+			curBdPtr = XAxiCdma_BdRingNext(&devCdma, curBdPtr);
+		}
+
 		do
 		{
-			isDmaError = XAxiCdma_SimpleTransfer(&devCdma, hostAddr, deviceAddr + deviceAddrOffset,
-													curDmaSize, NULL, NULL);
+			isDmaError = XAxiCdma_BdRingToHw(&devCdma, bdNum, bdPtr, NULL, NULL);
 			if(isDmaError)
 				DebugPrint("%s, %d\n\r", __FUNCTION__, __LINE__);
 		}
 		while(isDmaError);
 
-		while(XAxiCdma_IsBusy(&devCdma))
+		//wait until all descriptors are done and return them to the ring
+		doneCnt = 0;
+		while(doneCnt < bdNum)
+		{
+			cnt = XAxiCdma_BdRingFromHw(&devCdma, XAXICDMA_ALL_BDS, &bdPtr);
+			if(cnt > 0)
+			{
+				XAxiCdma_BdRingFree(&devCdma, cnt, bdPtr);
+				doneCnt += cnt;
+			}
+		}
+
+		//request, scatter list and completion are fetched by simple transfers
+		while(XAxiCdma_SwitchMode(&devCdma, XAXICDMA_SIMPLE_MODE) != XST_SUCCESS)
 		{
 		}
-		deviceAddrOffset += curDmaSize;
 	}
 
+	StatsCmdStage(STATS_STAGE_DMA_DONE);
+}
+
+void DmaDeviceToHost(P_HOST_CMD hostCmd, u32 deviceAddr, u32 reqSize, u32 scatterLength)
+{
+	DMA_CURSOR dmaCursor;
+
+	DmaStart(hostCmd, &dmaCursor);
+	DmaTransfer(hostCmd, &dmaCursor, deviceAddr, reqSize, DMA_DEVICE_TO_HOST);
+
 	DebugPrint("%x\n\r", Xil_In32(deviceAddr));
 }
 
-void CompleteCmd(P_HOST_CMD hostCmd)
+void DmaHostToDevice(P_HOST_CMD hostCmd, u32 deviceAddr, u32 reqSize, u32 scatterLength)
 {
-	u32 hostAddr, isDmaError;
+	DMA_CURSOR dmaCursor;
 
-	barAddrPtr.UpperAddr = Xil_In32(CONFIG_SPACE_COMPLETION_BASE_ADDR_U);
-	barAddrPtr.LowerAddr = Xil_In32(CONFIG_SPACE_COMPLETION_BASE_ADDR_L);
-	while(XAxiCdma_IsBusy(&devCdma))
-	{
-	}
-	XAxiPcie_SetLocalBusBar2PcieBar(&devPcie, 0x00, &barAddrPtr);
+	DmaStart(hostCmd, &dmaCursor);
+	DmaTransfer(hostCmd, &dmaCursor, deviceAddr, reqSize, DMA_HOST_TO_DEVICE);
 
-	//DebugPrint("Completion IO addr: 0x%x\n\r", Xil_In32(COMPLETION_IO_BASE_ADDR));
+	DebugPrint("%x\n\r", Xil_In32(deviceAddr));
+}
 
-	pCompletionIO->CmdStatus = hostCmd->CmdStatus;
-	pCompletionIO->ErrorStatus = hostCmd->ErrorStatus;
-	pCompletionIO->Done = 0;
+void InitCompletionRing()
+{
+	cplTail = 0;
+	cplPosted = 0;
+	cplPhase = 1;
+	cplReqCount = 0;
+}
 
-	pCompletionIO->debug_ReqCount++;
+// host driver programs the ring base at each load, even after an unclean stop, firmware restarts the ring at entry 0 as the driver does
+// completions staged for the former driver are dropped
+void CheckCompletionBase()
+{
+	u32 baseL = Xil_In32(CONFIG_SPACE_COMPLETION_BASE_ADDR_L);
 
+	if(baseL == COMPLETION_BASE_TAKEN)
+		return;
 
-	hostAddr = Xil_In32(CONFIG_SPACE_COMPLETION_BASE_ADDR_L) & DMA_ADDR_MASK;
-	hostAddr = XPAR_AXIPCIE_0_AXIBAR_0 + hostAddr;
+	cplBase.UpperAddr = Xil_In32(CONFIG_SPACE_COMPLETION_BASE_ADDR_U);
+	cplBase.LowerAddr = baseL;
+	Xil_Out32(CONFIG_SPACE_COMPLETION_BASE_ADDR_L, COMPLETION_BASE_TAKEN);
 
-	//DebugPrint("i = 0x%x\n\r", hostAddr);
-	//wait until cdma is idle
-	while(XAxiCdma_IsBusy(&devCdma))
+	InitCompletionRing();
+}
+
+void CompleteCmd(P_HOST_CMD hostCmd)
+{
+	P_COMPLETION_IO completionIO = &pCompletionIO[cplTail];
+
+	//stage completion entry, it is posted with others when firmware waits for a request
+	completionIO->CmdStatus = hostCmd->CmdStatus;
+	completionIO->ErrorStatus = hostCmd->ErrorStatus;
+	completionIO->debug_ReqCount = ++cplReqCount;
+	completionIO->Phase = cplPhase;
+
+	StatsCmdEnd();
+
+	cplTail++;
+	if(cplTail == COMPLETION_IO_DEPTH)
 	{
+		PostCompletion();
+		cplTail = 0;
+		cplPosted = 0;
+		cplPhase ^= 1;
 	}
-
-	do
+	else if((cplTail - cplPosted) >= COMPLETION_COALESCE_NUM)
 	{
-		isDmaError = XAxiCdma_SimpleTransfer(&devCdma, COMPLETION_IO_BASE_ADDR, hostAddr, sizeof(COMPLETION_IO), NULL, NULL);
-		if(isDmaError)
-			DebugPrint("%s, %d\n\r", __FUNCTION__, __LINE__);
+		PostCompletion();
 	}
-	while(isDmaError);
 
+	DebugPrint("return CompleteCmd\n\r\n\r\n\r");
+}
+
+void PostCompletion()
+{
+	u32 hostAddr, isDmaError;
+
+	if(cplPosted == cplTail)
+		return;
+
+	//host ring does not cross AXI BAR window as it lies in a page
+	hostAddr = SetBarWindow(BAR_WINDOW_COMPLETION, cplBase.UpperAddr, cplBase.LowerAddr + cplPosted * sizeof(COMPLETION_IO));
 
-	//DebugPrint("posting completion cmd without deadface... ");
+	//wait until cdma is idle
 	while(XAxiCdma_IsBusy(&devCdma))
 	{
 	}
-	//DebugPrint("done!\n\r");
-
-	pCompletionIO->Done = 0xdeadface;
 
 	do
 	{
-		isDmaError = XAxiCdma_SimpleTransfer(&devCdma, COMPLETION_IO_BASE_ADDR, hostAddr, sizeof(COMPLETION_IO), NULL, NULL);
+		isDmaError = XAxiCdma_SimpleTransfer(&devCdma, (u32)&pCompletionIO[cplPosted], hostAddr,
+					(cplTail - cplPosted) * sizeof(COMPLETION_IO), NULL, NULL);
 		if(isDmaError)
 			DebugPrint("%s, %d\n\r", __FUNCTION__, __LINE__);
 	}
 	while(isDmaError);
-	
-	//DebugPrint("posting completion cmd with deadface... ");
+
+	DebugPrint("posting completion... ");
 	while(XAxiCdma_IsBusy(&devCdma))
 	{
 	}
-	//DebugPrint("done!\n\r");
+	DebugPrint("done!\n\r");
 
-	DebugPrint("return CompleteCmd\n\r\n\r\n\r");
+	cplPosted = cplTail;
 }
 
 #endif /* HOST_CONTROLLER_C_ */
@@ -30,7 +30,7 @@
 // Design Name: Host Controller
 // File Name: host_controller.h
 //
-// Version: v1.1.0
+// Version: v1.6.2
 //
 // Description:
 //   - Provides host interface (GetRequestCmd, DmaDeviceToHost, CompleteCmd, ...)
@@ -39,6 +39,30 @@
 //////////////////////////////////////////////////////////////////////////////////
 // Revision History:
 //
+// * v1.6.2
+//   - add mark of a completion base address taken by firmware
+//
+// * v1.6.1
+//   - add buffer address of SMART data
+//
+// * v1.6.0
+//   - add statistics region read by host
+//
+// * v1.5.0
+//   - completion is posted to a ring by a single DMA, new entries are told by a phase bit
+//
+// * v1.4.0
+//   - add AXI BAR window cache, request, completion and data get their own window if available
+//
+// * v1.3.0
+//   - add descriptor ring of CentralDMA for scatter-gather data transfer
+//
+// * v1.2.1
+//   - device address is given to each partial transfer
+//
+// * v1.2.0
+//   - add DMA cursor for partial data transfer
+//
 // * v1.1.0
 //   - Support shutdown command (not ATA command)
 //   - Move sector count information from driver to device firmware
@@ -74,11 +98,14 @@
 #define COMPLETION_IO_DONE_ADDR					COMPLETION_IO_BASE_ADDR
 
 #define HOST_SCATTER_REGION_BASE_ADDR			0x01200000
+#define CDMA_BD_RING_BASE_ADDR					0x01300000
 
 #define IDENTIFY_DEVICE_DATA_BASE_ADDR 			0x02000000
 #define IDENTIFY_DEVICE_ALIGNED_DATA_BASE_ADDR 	0x02100000
 #define IDENTIFY_DEVICE_GET_BACK_DATA_BASE_ADDR 0x02200000
 #define IDENTIFY_DEVICE_ID_DATA_BASE_ADDR 		0x02300000
+#define STATS_BASE_ADDR							0x02400000
+#define SMART_DATA_BASE_ADDR					0x02500000
 
 #define RAM_DISK_BASE_ADDR						0x10000000
 
@@ -87,10 +114,32 @@
 #define DMA_WINDOW_SIZE		(XPAR_AXIPCIE_0_AXIBAR_HIGHADDR_0 - XPAR_AXIPCIE_0_AXIBAR_0 + 1)
 #define DMA_ADDR_MASK		(XPAR_AXIPCIE_0_AXIBAR_HIGHADDR_0 - XPAR_AXIPCIE_0_AXIBAR_0)
 
+// AXI BAR windows for request, completion and data
+// they share a window when the bridge has less than three AXI BARs, all windows are DMA_WINDOW_SIZE long
+#if (XPAR_PCI_EXPRESS_AXIBAR_NUM >= 3)
+#define BAR_WINDOW_NUM			3
+#define BAR_WINDOW_REQUEST		0
+#define BAR_WINDOW_COMPLETION	1
+#define BAR_WINDOW_DATA			2
+#else
+#define BAR_WINDOW_NUM			1
+#define BAR_WINDOW_REQUEST		0
+#define BAR_WINDOW_COMPLETION	0
+#define BAR_WINDOW_DATA			0
+#endif
+
+// descriptors of a scatter-gather transfer, scatter regions in an AXI BAR window are chained up to this number
+#define CDMA_BD_NUM			64
+
 
 
 #define	REQUEST_IO_DEPTH					(0x1 << 0)
-#define	COMPLETION_IO_DEPTH					(0x1 << 0)
+#define	COMPLETION_IO_DEPTH					(0x1 << 6)	// entries of completion ring, same as the driver, ring fits in a 4KB host page
+#define	COMPLETION_COALESCE_NUM				(0x1 << 3)	// completions staged before they are posted regardless of requests
+#define	COMPLETION_BASE_TAKEN				0xffffffff	// written over the low base address once firmware has taken it, ring entries are never there
+
+#define	DMA_DEVICE_TO_HOST					(0x0)
+#define	DMA_HOST_TO_DEVICE					(0x1)
 
 #define	COMMAND_STATUS_SUCCESS				(0x01)
 #define	COMMAND_STATUS_ERROR				(0x02)
@@ -127,12 +176,13 @@ typedef struct _REQUEST_IO
 }REQUEST_IO, *P_REQUEST_IO;
 
 
+// phase is the last word so that it lands after the status of the entry
 typedef struct _COMPLETION_IO
 {
-	u32	Done;
 	u32	CmdStatus;
 	u32	ErrorStatus;
 	u32 debug_ReqCount;
+	u32	Phase;		// flipped at each wrap of the ring, host takes an entry whose phase is what it expects
 }COMPLETION_IO, *P_COMPLETION_IO;
 
 
@@ -155,6 +205,13 @@ typedef struct _HOST_CMD
 	REQUEST_IO	reqInfo;
 }HOST_CMD, *P_HOST_CMD;
 
+// progress of a data DMA transferred part by part
+typedef struct _DMA_CURSOR
+{
+	u32	curScatterRegionNum;
+	u32	acc;					// bytes already transferred in the current scatter region
+}DMA_CURSOR, *P_DMA_CURSOR;
+
 
 
 u32 CheckRequest();
@@ -163,12 +220,28 @@ u32 GetRequestCmd(P_HOST_CMD hostCmd);
 
 u32 GetHostScatterRegion(P_HOST_CMD hostCmd);
 
+void InitCdmaBdRing();
+
+void InitBarWindow();
+
+u32 SetBarWindow(u32 window, u32 hostAddrU, u32 hostAddrL);
+
+void DmaStart(P_HOST_CMD hostCmd, P_DMA_CURSOR dmaCursor);
+
+void DmaTransfer(P_HOST_CMD hostCmd, P_DMA_CURSOR dmaCursor, u32 deviceAddr, u32 size, u32 direction);
+
 void DmaDeviceToHost(P_HOST_CMD hostCmd, u32 deviceAddr, u32 reqSize, u32 scatterLength);
 
 void DmaHostToDevice(P_HOST_CMD hostCmd, u32 deviceAddr, u32 reqSize, u32 scatterLength);
 
+void InitCompletionRing();
+
+void CheckCompletionBase();
+
 void CompleteCmd(P_HOST_CMD hostCmd);
 
+void PostCompletion();
+
 
 //#define __DEBUG__
 
@@ -30,7 +30,7 @@
 // Design Name: Identify
 // File Name: identify.c
 //
-// Version: v1.0.0
+// Version: v1.0.1
 //
 // Description:
 //   - Generate device identify data for windows driver.
@@ -39,6 +39,9 @@
 //////////////////////////////////////////////////////////////////////////////////
 // Revision History:
 //
+// * v1.0.1
+//   - report SMART feature set as supported and enabled
+//
 // * v1.0.0
 //   - First draft
 //////////////////////////////////////////////////////////////////////////////////
@@ -183,7 +186,7 @@ void InitIdentifyData(P_IDENTIFY_DEVICE_DATA IdentifyData)
 															//    struct
 															//    {
 															//        // Word 82
-	//IdentifyData->CommandSetSupport.SmartCommands = 1;	//        u16 SmartCommands : 1;
+	IdentifyData->CommandSetSupport.SmartCommands = 1;		//        u16 SmartCommands : 1;
 	IdentifyData->CommandSetSupport.SecurityMode = 1;		//        u16 SecurityMode : 1;
 															//        u16 RemovableMediaFeature : 1;
 	IdentifyData->CommandSetSupport.PowerManagement = 1;	//        u16 PowerManagement : 1;
@@ -238,7 +241,7 @@ void InitIdentifyData(P_IDENTIFY_DEVICE_DATA IdentifyData)
 															//    struct
 															//	  {
 															//        // Word 85
-	//IdentifyData->CommandSetActive.SmartCommands = 1;		//        u16 SmartCommands : 1;
+	IdentifyData->CommandSetActive.SmartCommands = 1;		//        u16 SmartCommands : 1;
 															//        u16 SecurityMode : 1;
 															//        u16 RemovableMediaFeature : 1;
 	IdentifyData->CommandSetActive.PowerManagement = 1;		//        u16 PowerManagement : 1;
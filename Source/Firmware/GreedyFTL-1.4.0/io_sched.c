@@ -0,0 +1,265 @@
+//////////////////////////////////////////////////////////////////////////////////
+// io_sched.c for Cosmos OpenSSD
+// Copyright (c) 2014 Hanyang University ENC Lab.
+// Contributed by Yong Ho Song <yhsong@enc.hanyang.ac.kr>
+//                Gyeongyong Lee <gylee@enc.hanyang.ac.kr>
+//			      Jaewook Kwak <jwkwak@enc.hanyang.ac.kr>
+//
+// This file is part of Cosmos OpenSSD.
+//
+// Cosmos OpenSSD is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3, or (at your option)
+// any later version.
+//
+// Cosmos OpenSSD is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Cosmos OpenSSD; see the file COPYING.
+// If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////////////////
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// Company: ENC Lab. <http://enc.hanyang.ac.kr>
+// Engineer: Gyeongyong Lee <gylee@enc.hanyang.ac.kr>
+//			 Jaewook Kwak <jwkwak@enc.hanyang.ac.kr>
+//
+// Project Name: Cosmos OpenSSD
+// Design Name: Greedy FTL
+// Module Name: I/O Scheduler
+// File Name: io_sched.c
+//
+// Version: v1.0.0
+//
+// Description:
+//   - per-die dispatch of NAND commands of FTL by class, host read, host write, GC and meta data
+//   - host write programs finding their die busy wait in a queue of the die instead of holding up the request
+//   - host reads go ahead of queued programs, programs past their deadline go ahead of GC and meta data commands
+//   - GC programs take a share of a die while host write programs are queued on it
+//////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////
+// Revision History:
+//
+// * v1.0.0
+//   - First draft
+//////////////////////////////////////////////////////////////////////////////////
+
+#include "io_sched.h"
+
+#include "xtime_l.h"
+
+#include "lld.h"
+#include "pagemap.h"
+
+#define IO_DEADLINE_COUNT	((u32)(IO_WRITE_DEADLINE_US * (COUNTS_PER_SECOND / 1000000)))
+
+void InitIoSched()
+{
+	ioSched = (struct ioSchedArray*)(IO_SCHED_ADDR);
+
+	u32 dieNo;
+	for(dieNo=0 ; dieNo<DIE_NUM ; dieNo++)
+	{
+		ioSched->ioDie[dieNo].head = 0;
+		ioSched->ioDie[dieNo].cnt = 0;
+		ioSched->ioDie[dieNo].readHold = 0;
+		ioSched->ioDie[dieNo].gcCredit = 0;
+	}
+
+	xil_printf("[ ssd i/o scheduler initialized. ]\r\n");
+}
+
+static int IoOverdue(u32 dieNo)
+{
+	struct ioDie* die = &ioSched->ioDie[dieNo];
+	XTime now;
+
+	if(die->cnt == 0)
+		return 0;
+
+	XTime_GetTime(&now);
+	return (int)((u32)now - die->deadline[die->head]) >= 0;
+}
+
+// the oldest queued program is issued when the die is free, the buffer of the host write program before it returns to the pool
+static void IoIssueWrite(u32 dieNo)
+{
+	writeBuf = (struct wbArray*)(WRITE_MAP_ADDR);
+
+	struct ioDie* die = &ioSched->ioDie[dieNo];
+	u32 head = die->head;
+
+	die->head = (head + 1) % IO_WRITE_QUEUE_DEPTH;
+	die->cnt--;
+
+	WaitWayFree(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM);
+	if(writeBuf->progBuf[dieNo] != 0xffffffff)
+		ReleaseWriteBuf(dieNo);
+
+	SsdProgram(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM, die->rowAddr[head], die->bufAddr[head]);
+	writeBuf->progBuf[dieNo] = die->bufAddr[head];
+
+	// credit of GC is not saved up beyond a program
+	die->gcCredit += IO_GC_SHARE;
+	if(die->gcCredit > 100)
+		die->gcCredit = 100;
+}
+
+// the oldest queued program goes to a free die unless a host read request holds the die
+static void IoDispatchDie(u32 dieNo)
+{
+	struct ioDie* die = &ioSched->ioDie[dieNo];
+
+	if(die->cnt && (!die->readHold || IoOverdue(dieNo)) && (SsdReadChWayStatus(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM) == 0))
+		IoIssueWrite(dieNo);
+}
+
+// queued programs issued before a command of the class to the die
+static void IoMakeWay(u32 dieNo, u32 ioClass, u32 cmd, u32 rowAddr)
+{
+	struct ioDie* die = &ioSched->ioDie[dieNo];
+	u32 i, row, issueCnt;
+
+	// a page is read after its program, pages of a block are programmed in order and before the block is erased
+	issueCnt = 0;
+	for(i=0 ; i<die->cnt ; i++)
+	{
+		row = die->rowAddr[(die->head + i) % IO_WRITE_QUEUE_DEPTH];
+		if((cmd == SSD_CMD_READ) ? (row == rowAddr) : (row / PAGE_NUM_PER_BLOCK == rowAddr / PAGE_NUM_PER_BLOCK))
+			issueCnt = i + 1;
+	}
+	for( ; issueCnt ; issueCnt--)
+		IoIssueWrite(dieNo);
+
+	if(ioClass == IO_CLASS_HOST_READ)
+		return;
+
+	while(IoOverdue(dieNo))
+		IoIssueWrite(dieNo);
+
+	// a GC program waits for host write programs until they have earned its turn
+	if((ioClass == IO_CLASS_GC) && (cmd == SSD_CMD_PROG) && die->cnt)
+	{
+		while(die->cnt && (die->gcCredit < 100 - IO_GC_SHARE))
+			IoIssueWrite(dieNo);
+
+		die->gcCredit = (die->gcCredit < 100 - IO_GC_SHARE) ? 0 : die->gcCredit - (100 - IO_GC_SHARE);
+	}
+}
+
+// returns 1 if a host read has completed under a suspended operation as SsdHostRead() does
+int IoRead(u32 dieNo, u32 ioClass, u32 rowAddr, u32 dstAddr)
+{
+	ioSched = (struct ioSchedArray*)(IO_SCHED_ADDR);
+
+	IoMakeWay(dieNo, ioClass, SSD_CMD_READ, rowAddr);
+
+	if(ioClass == IO_CLASS_HOST_READ)
+		return SsdHostRead(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM, rowAddr, dstAddr);
+
+	WaitWayFree(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM);
+	return SsdRead(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM, rowAddr, dstAddr);
+}
+
+int IoProgram(u32 dieNo, u32 ioClass, u32 rowAddr, u32 srcAddr)
+{
+	ioSched = (struct ioSchedArray*)(IO_SCHED_ADDR);
+
+	IoMakeWay(dieNo, ioClass, SSD_CMD_PROG, rowAddr);
+
+	WaitWayFree(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM);
+	return SsdProgram(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM, rowAddr, srcAddr);
+}
+
+int IoErase(u32 dieNo, u32 ioClass, u32 blockNo)
+{
+	ioSched = (struct ioSchedArray*)(IO_SCHED_ADDR);
+
+	IoMakeWay(dieNo, ioClass, SSD_CMD_ERASE, blockNo * PAGE_NUM_PER_BLOCK);
+
+	WaitWayFree(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM);
+	return SsdErase(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM, blockNo);
+}
+
+// program of host data from a write buffer, the request goes on while the program waits for its die
+void IoQueueProgram(u32 dieNo, u32 rowAddr, u32 bufAddr)
+{
+	ioSched = (struct ioSchedArray*)(IO_SCHED_ADDR);
+
+	struct ioDie* die = &ioSched->ioDie[dieNo];
+	u32 tail;
+	XTime now;
+
+	// a full queue issues its oldest program first
+	if(die->cnt == IO_WRITE_QUEUE_DEPTH)
+		IoIssueWrite(dieNo);
+
+	XTime_GetTime(&now);
+	tail = (die->head + die->cnt) % IO_WRITE_QUEUE_DEPTH;
+	die->rowAddr[tail] = rowAddr;
+	die->bufAddr[tail] = bufAddr;
+	die->deadline[tail] = (u32)now + IO_DEADLINE_COUNT;
+	die->cnt++;
+
+	IoDispatchDie(dieNo);
+}
+
+// queued programs go to free dies, called while host is idle and between pages of a read request
+void IoDispatch()
+{
+	ioSched = (struct ioSchedArray*)(IO_SCHED_ADDR);
+
+	u32 dieNo;
+	for(dieNo=0 ; dieNo<DIE_NUM ; dieNo++)
+		IoDispatchDie(dieNo);
+}
+
+// queued programs of the die wait for the end of the read request unless they are past their deadline
+void IoHoldRead(u32 dieNo)
+{
+	ioSched = (struct ioSchedArray*)(IO_SCHED_ADDR);
+
+	ioSched->ioDie[dieNo].readHold = 1;
+}
+
+void IoReleaseRead()
+{
+	ioSched = (struct ioSchedArray*)(IO_SCHED_ADDR);
+
+	u32 dieNo;
+	for(dieNo=0 ; dieNo<DIE_NUM ; dieNo++)
+		ioSched->ioDie[dieNo].readHold = 0;
+
+	IoDispatch();
+}
+
+// a write buffer returns to the pool by issuing a queued program of the die or by waiting for the program in execution
+void IoReclaimWriteBuf(u32 dieNo)
+{
+	ioSched = (struct ioSchedArray*)(IO_SCHED_ADDR);
+	writeBuf = (struct wbArray*)(WRITE_MAP_ADDR);
+
+	if(ioSched->ioDie[dieNo].cnt)
+		IoIssueWrite(dieNo);
+	else if(writeBuf->progBuf[dieNo] != 0xffffffff)
+	{
+		WaitWayFree(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM);
+		ReleaseWriteBuf(dieNo);
+	}
+}
+
+// all queued programs are issued, the caller waits for dies to complete them
+void IoDrain()
+{
+	ioSched = (struct ioSchedArray*)(IO_SCHED_ADDR);
+
+	u32 dieNo;
+	for(dieNo=0 ; dieNo<DIE_NUM ; dieNo++)
+		while(ioSched->ioDie[dieNo].cnt)
+			IoIssueWrite(dieNo);
+}
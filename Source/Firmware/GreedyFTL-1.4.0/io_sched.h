@@ -0,0 +1,88 @@
+//////////////////////////////////////////////////////////////////////////////////
+// io_sched.h for Cosmos OpenSSD
+// Copyright (c) 2014 Hanyang University ENC Lab.
+// Contributed by Yong Ho Song <yhsong@enc.hanyang.ac.kr>
+//                Gyeongyong Lee <gylee@enc.hanyang.ac.kr>
+//			      Jaewook Kwak <jwkwak@enc.hanyang.ac.kr>
+//
+// This file is part of Cosmos OpenSSD.
+//
+// Cosmos OpenSSD is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3, or (at your option)
+// any later version.
+//
+// Cosmos OpenSSD is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Cosmos OpenSSD; see the file COPYING.
+// If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////
+// Company: ENC Lab. <http://enc.hanyang.ac.kr>
+// Engineer: Gyeongyong Lee <gylee@enc.hanyang.ac.kr>
+//			 Jaewook Kwak <jwkwak@enc.hanyang.ac.kr>
+//
+// Project Name: Cosmos OpenSSD
+// Design Name: Greedy FTL
+// Module Name: I/O Scheduler
+// File Name: io_sched.h
+//
+// Version: v1.0.0
+//
+// Description:
+//   - define classes of NAND commands and queues of host write programs of each die
+//////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////
+// Revision History:
+//
+// * v1.0.0
+//   - First draft
+//////////////////////////////////////////////////////////////////////////////////
+
+#ifndef IO_SCHED_H_
+#define IO_SCHED_H_
+
+#include "xil_types.h"
+#include "ftl.h"
+
+// classes of NAND commands issued by FTL
+#define IO_CLASS_HOST_READ		0	// goes ahead of queued host write programs and suspends an operation in execution
+#define IO_CLASS_HOST_WRITE		1	// programs are queued when their die is busy or read by a host request
+#define IO_CLASS_GC				2	// programs take IO_GC_SHARE of a die while host write programs are queued on it
+#define IO_CLASS_META			3	// map, page map and meta data pages, go ahead of queued host write programs
+
+// host write programs of a die waiting for the die in order of their pages, ring of IO_WRITE_QUEUE_DEPTH
+struct ioDie {
+	u32 rowAddr[IO_WRITE_QUEUE_DEPTH];
+	u32 bufAddr[IO_WRITE_QUEUE_DEPTH];	// write buffer returned to the pool after the program
+	u32 deadline[IO_WRITE_QUEUE_DEPTH];	// global timer count after which the program goes ahead of any other command
+	u32 head;
+	u32 cnt;
+	u32 readHold;	// a host read request has pages to read from the die
+	u32 gcCredit;	// programs GC may take ahead of queued host write programs, in 1/100 program
+};
+
+struct ioSchedArray {
+	struct ioDie ioDie[DIE_NUM];
+};
+
+struct ioSchedArray* ioSched;
+
+void InitIoSched();
+int IoRead(u32 dieNo, u32 ioClass, u32 rowAddr, u32 dstAddr);
+int IoProgram(u32 dieNo, u32 ioClass, u32 rowAddr, u32 srcAddr);
+int IoErase(u32 dieNo, u32 ioClass, u32 blockNo);
+void IoQueueProgram(u32 dieNo, u32 rowAddr, u32 bufAddr);
+void IoDispatch();
+void IoHoldRead(u32 dieNo);
+void IoReleaseRead();
+void IoReclaimWriteBuf(u32 dieNo);
+void IoDrain();
+
+#endif /* IO_SCHED_H_ */
@@ -32,17 +32,30 @@
 // Module Name: Low Level Driver
 // File Name: lld.c
 //
-// Version: v1.0.3
+// Version: v1.3.1
 //
 // Description: 
 //   - interface to NAND flash memory controller
 //   - reset, mode change, status check
 //   - erase, read, program
+//   - program/erase suspend and resume
 //////////////////////////////////////////////////////////////////////////////////
 
 //////////////////////////////////////////////////////////////////////////////////
 // Revision History:
 //
+// * v1.3.1
+//   - host read does not suspend the program of the page it reads
+//
+// * v1.3.0
+//   - host read suspends a program or erase in execution on its die when SUSPEND_ENABLE is set
+//
+// * v1.2.0
+//   - count programmed pages for SMART
+//
+// * v1.1.0
+//   - record busy time of each die from issue to observed completion
+//
 // * v1.0.3
 //   - replace bitwise operation with decimal operation
 //
@@ -61,6 +74,14 @@
 #include "xil_io.h"
 
 #include "ftl.h"
+#include "stats.h"
+#include "smart.h"
+
+// state of each die for program/erase suspend
+static u32 dieOp[DIE_NUM];	// command last issued, a suspended command stays here
+static u32 dieSuspendCnt[DIE_NUM];	// suspends of the program or erase in execution
+static u32 dieReadDone[DIE_NUM];	// the last read completed while the die was suspended
+static u32 dieProgRow[DIE_NUM];	// row of the program last issued
 
 int SsdReset(u32 chNo, u32 wayNo)
 {
@@ -154,7 +175,10 @@ int SsdReadChWayStatus(u32 chNo, u32 wayNo)
   if((chStatus & rbMask) == rbMask)
   {
     if((chStatus & errMask) == 0)	// previous operation has passed!
+    {
+      StatsDieDone(chNo + wayNo * CHANNEL_NUM);
       return 0;
+    }
     else	// previous operation has failed!
       return 1;
   }
@@ -254,21 +278,125 @@ int SsdPageProgram(u32 chNo, u32 wayNo, u32 rowAddr, u32 srcAddr)
   return 0;
 }
 
+int SsdSuspend(u32 chNo, u32 wayNo)
+{
+  switch(chNo)
+  {
+    case 0:
+      WriteCh0Command(wayNo, SSD_CMD_SUSPEND);
+      break;
+
+    case 1:
+      WriteCh1Command(wayNo, SSD_CMD_SUSPEND);
+      break;
+
+    case 2:
+      WriteCh2Command(wayNo, SSD_CMD_SUSPEND);
+      break;
+
+    case 3:
+      WriteCh3Command(wayNo, SSD_CMD_SUSPEND);
+      break;
+  }
+
+  return 0;
+}
+
+int SsdResume(u32 chNo, u32 wayNo)
+{
+  StatsDieIssue(chNo + wayNo * CHANNEL_NUM);	// the rest of the operation keeps the die busy
+
+  switch(chNo)
+  {
+    case 0:
+      WriteCh0Command(wayNo, SSD_CMD_RESUME);
+      break;
+
+    case 1:
+      WriteCh1Command(wayNo, SSD_CMD_RESUME);
+      break;
+
+    case 2:
+      WriteCh2Command(wayNo, SSD_CMD_RESUME);
+      break;
+
+    case 3:
+      WriteCh3Command(wayNo, SSD_CMD_RESUME);
+      break;
+  }
+
+  return 0;
+}
+
 int SsdErase(u32 chNo, u32 wayNo, u32 blockNo)
 {
+	StatsDieIssue(chNo + wayNo * CHANNEL_NUM);
+	dieOp[chNo + wayNo * CHANNEL_NUM] = SSD_CMD_ERASE;
+	dieSuspendCnt[chNo + wayNo * CHANNEL_NUM] = 0;
 	return SsdBlockErase(chNo, wayNo, blockNo * PAGE_NUM_PER_BLOCK);
 }
 
 int SsdRead(u32 chNo, u32 wayNo, u32 rowAddr, u32 dstAddr)
 {
+	StatsDieIssue(chNo + wayNo * CHANNEL_NUM);
+	dieOp[chNo + wayNo * CHANNEL_NUM] = SSD_CMD_READ;
+	dieReadDone[chNo + wayNo * CHANNEL_NUM] = 0;
 	return SsdPageRead(chNo, wayNo, rowAddr, dstAddr);
 }
 
 int SsdProgram(u32 chNo, u32 wayNo, u32 rowAddr, u32 srcAddr)
 {
+	StatsDieIssue(chNo + wayNo * CHANNEL_NUM);
+	SmartProgram();
+	dieOp[chNo + wayNo * CHANNEL_NUM] = SSD_CMD_PROG;
+	dieProgRow[chNo + wayNo * CHANNEL_NUM] = rowAddr;
+	dieSuspendCnt[chNo + wayNo * CHANNEL_NUM] = 0;
 	return SsdPageProgram(chNo, wayNo, rowAddr, srcAddr);
 }
 
+// read of a host request, a program or erase in execution is suspended for it up to SUSPEND_MAX_NUM times
+// a program of the very page to be read is not suspended, the read waits for its data to be programmed
+// returns 1 if the read has completed and the operation is resumed, 0 if the read is issued after the die is free
+int SsdHostRead(u32 chNo, u32 wayNo, u32 rowAddr, u32 dstAddr)
+{
+#if SUSPEND_ENABLE
+	u32 dieNo = chNo + wayNo * CHANNEL_NUM;
+	u32 op = dieOp[dieNo];
+	int status;
+
+	if(((op == SSD_CMD_PROG) || (op == SSD_CMD_ERASE)) && (dieSuspendCnt[dieNo] < SUSPEND_MAX_NUM)
+		&& !((op == SSD_CMD_PROG) && (dieProgRow[dieNo] == rowAddr)))
+	{
+		status = SsdReadChWayStatus(chNo, wayNo);
+		if((status != 0) && (status != 1))	// busy
+		{
+			dieSuspendCnt[dieNo]++;
+			SsdSuspend(chNo, wayNo);
+			WaitWayFree(chNo, wayNo);
+
+			SsdRead(chNo, wayNo, rowAddr, dstAddr);
+			WaitWayFree(chNo, wayNo);
+
+			SsdResume(chNo, wayNo);
+			dieOp[dieNo] = op;
+			dieReadDone[dieNo] = 1;
+			return 1;
+		}
+	}
+#endif
+
+	WaitWayFree(chNo, wayNo);
+	SsdRead(chNo, wayNo, rowAddr, dstAddr);
+	return 0;
+}
+
+// the last read of a die may have completed under a suspended operation, which must not be waited for
+void WaitWayRead(u32 ch, u32 way)
+{
+	if(!dieReadDone[ch + way * CHANNEL_NUM])
+		WaitWayFree(ch, way);
+}
+
 void WaitWayFree(u32 ch, u32 way)
 {
 	for( ; ; )
@@ -30,7 +30,7 @@
 // Module Name: Low Level Driver
 // File Name: lld.h
 //
-// Version: v1.1.1
+// Version: v1.2.0
 //
 // Description: 
 //   - define basic functions and parameters
@@ -39,6 +39,9 @@
 //////////////////////////////////////////////////////////////////////////////////
 // Revision History:
 //
+// * v1.2.0
+//   - add program/erase suspend and resume
+//
 // * v1.1.1
 //   - change in naming convention
 //
@@ -81,6 +84,8 @@
 #define SSD_CMD_RESET       0x000000ff
 #define SSD_CMD_MODE_CHANGE 0x000000ef
 #define SSD_CMD_READ_ID     0x00000090
+#define SSD_CMD_SUSPEND     0x00000061	// program/erase suspend, the die is ready when the operation is suspended
+#define SSD_CMD_RESUME      0x000000d2	// resume of the suspended operation
 
 #define WAY_RB_MASK         0x20202020
 #define WAY_ERR_MASK        0x03030303
@@ -142,6 +147,11 @@ int SsdErase(u32 chNo, u32 wayNo, u32 blockNo);
 int SsdRead(u32 chNo, u32 wayNo, u32 rowAddr, u32 dstAddr);
 int SsdProgram(u32 chNo, u32 wayNo, u32 rowAddr, u32 srcAddr);
 
+int SsdSuspend(u32 chNo, u32 wayNo);
+int SsdResume(u32 chNo, u32 wayNo);
+int SsdHostRead(u32 chNo, u32 wayNo, u32 rowAddr, u32 dstAddr);
+
 void WaitWayFree(u32 ch, u32 way);
+void WaitWayRead(u32 ch, u32 way);
 
 #endif /* LLD_H_ */
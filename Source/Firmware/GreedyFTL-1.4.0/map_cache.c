@@ -0,0 +1,365 @@
+//////////////////////////////////////////////////////////////////////////////////
+// map_cache.c for Cosmos OpenSSD
+// Copyright (c) 2014 Hanyang University ENC Lab.
+// Contributed by Yong Ho Song <yhsong@enc.hanyang.ac.kr>
+//                Gyeongyong Lee <gylee@enc.hanyang.ac.kr>
+//				  Jaewook Kwak <jwkwak@@enc.hanyang.ac.kr>
+//
+// This file is part of Cosmos OpenSSD.
+//
+// Cosmos OpenSSD is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3, or (at your option)
+// any later version.
+//
+// Cosmos OpenSSD is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Cosmos OpenSSD; see the file COPYING.
+// If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////
+// Company: ENC Lab. <http://enc.hanyang.ac.kr>
+// Engineer: Gyeongyong Lee <gylee@enc.hanyang.ac.kr>
+//			 Jaewook Kwak <jwkwak@enc.hanyang.ac.kr>
+//
+// Project Name: Cosmos OpenSSD
+// Design Name: Greedy FTL
+// Module Name: Mapping Table Cache
+// File Name: map_cache.c
+//
+// Version: v1.1.2
+//
+// Description:
+//   - L2P table access
+//   - demand paging of translation pages when MAP_CACHE_ENABLE is set
+//////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////
+// Revision History:
+//
+// * v1.1.2
+//   - translation pages are read, programmed and erased through the I/O scheduler
+//
+// * v1.1.1
+//   - loop indices are unsigned like the values they are compared with
+//
+// * v1.1.0
+//   - L2P entries of dedup entries are kept in dedup map
+//
+// * v1.0.1
+//   - count erases of translation blocks for SMART
+//
+// * v1.0.0
+//   - First draft
+//////////////////////////////////////////////////////////////////////////////////
+
+#include "map_cache.h"
+
+#include <assert.h>
+
+#include "lld.h"
+#include "pagemap.h"
+
+#include <string.h>
+
+void InitMapCache()
+{
+#if MAP_CACHE_ENABLE
+	cmtMap = (struct cmtArray*)(CMT_ADDR);
+
+	// all slots are empty and linked in LRU order
+	u32 i, j;
+	for(i=0 ; i<MAP_CACHE_SLOT_NUM ; i++)
+	{
+		cmtMap->cmtEntry[i].dieNo = 0xff;
+		cmtMap->cmtEntry[i].dirty = 0;
+		cmtMap->cmtEntry[i].transPageNo = 0;
+		cmtMap->cmtEntry[i].prevSlot = (i == 0) ? 0xffffffff : i - 1;
+		cmtMap->cmtEntry[i].nextSlot = (i == MAP_CACHE_SLOT_NUM - 1) ? 0xffffffff : i + 1;
+	}
+	cmtMap->head = 0;
+	cmtMap->tail = MAP_CACHE_SLOT_NUM - 1;
+
+	for(i=0 ; i<DIE_NUM ; i++)
+		for(j=0 ; j<TRANS_PAGE_NUM_PER_DIE ; j++)
+			cmtMap->slotIndex[i][j] = 0xffffffff;
+
+	cmtMap->hitCnt = 0;
+	cmtMap->missCnt = 0;
+
+	xil_printf("[ ssd map cache initialized. ]\r\n");
+#else
+	l2pMap = (struct l2pArray*)(L2P_MAP_ADDR);
+
+	int i, j;
+	for(i=0 ; i<DIE_NUM ; i++)
+		for(j=0 ; j<SUB_PAGE_NUM_PER_DIE ; j++)
+			l2pMap->l2pEntry[i][j] = 0xffffffff;
+
+	xil_printf("[ ssd L2P map initialized. ]\r\n");
+#endif
+}
+
+void InitTransBlock()
+{
+#if MAP_CACHE_ENABLE
+	blockMap = (struct bmArray*)(BLOCK_MAP_ADDR);
+	gtdMap = (struct gtdArray*)(GTD_ADDR);
+	transBlock = (struct tbArray*)(TRANS_MAP_ADDR);
+
+	int i, j, blockNo;
+	for(i=0 ; i<DIE_NUM ; i++)
+	{
+		for(j=0 ; j<TRANS_PAGE_NUM_PER_DIE ; j++)
+			gtdMap->gtdEntry[i][j] = 0xffffffff;
+
+		// translation blocks are taken from the end of each die except the free block for GC
+		blockNo = BLOCK_NUM_PER_DIE - 2;
+		for(j=0 ; j<TRANS_BLOCK_NUM_PER_DIE ; j++)
+		{
+			while(blockMap->bmEntry[i][blockNo].bad)
+				blockNo--;
+
+			blockMap->bmEntry[i][blockNo].free = 0;
+			transBlock->tbEntry[i].block[j] = blockNo;
+			transBlock->tbEntry[i].validCnt[j] = 0;
+			transBlock->tbEntry[i].currentPage[j] = 0;
+			blockNo--;
+		}
+		transBlock->tbEntry[i].activeBlock = 0;
+	}
+
+	xil_printf("[ ssd translation blocks initialized. ]\r\n");
+#endif
+}
+
+u32 GetL2P(u32 dieNo, u32 dieLpn)
+{
+#if DEDUP_ENABLE
+	// shared physical sub-page is mapped by its dedup entry
+	if(IS_DEDUP_ID(dieLpn))
+	{
+		dedupMap = (struct dedupArray*)(DEDUP_MAP_ADDR);
+
+		return dedupMap->dedupEntry[dieNo][dieLpn - DEDUP_ID_BASE].ppn;
+	}
+#endif
+#if MAP_CACHE_ENABLE
+	u32* transPage = (u32*)LoadTransPage(dieNo, dieLpn / TRANS_ENTRY_NUM_PER_PAGE);
+
+	return transPage[dieLpn % TRANS_ENTRY_NUM_PER_PAGE];
+#else
+	l2pMap = (struct l2pArray*)(L2P_MAP_ADDR);
+
+	return l2pMap->l2pEntry[dieNo][dieLpn];
+#endif
+}
+
+void SetL2P(u32 dieNo, u32 dieLpn, u32 ppn)
+{
+#if DEDUP_ENABLE
+	if(IS_DEDUP_ID(dieLpn))
+	{
+		dedupMap = (struct dedupArray*)(DEDUP_MAP_ADDR);
+
+		dedupMap->dedupEntry[dieNo][dieLpn - DEDUP_ID_BASE].ppn = ppn;
+		return;
+	}
+#endif
+#if MAP_CACHE_ENABLE
+	u32* transPage = (u32*)LoadTransPage(dieNo, dieLpn / TRANS_ENTRY_NUM_PER_PAGE);
+
+	transPage[dieLpn % TRANS_ENTRY_NUM_PER_PAGE] = ppn;
+	cmtMap->cmtEntry[cmtMap->head].dirty = 1;	// loaded translation page is at the head
+#else
+	l2pMap = (struct l2pArray*)(L2P_MAP_ADDR);
+
+	l2pMap->l2pEntry[dieNo][dieLpn] = ppn;
+#endif
+}
+
+#if MAP_CACHE_ENABLE
+
+u32 LoadTransPage(u32 dieNo, u32 transPageNo)
+{
+	cmtMap = (struct cmtArray*)(CMT_ADDR);
+	gtdMap = (struct gtdArray*)(GTD_ADDR);
+
+	u32 slot = cmtMap->slotIndex[dieNo][transPageNo];
+	u32 prevSlot, nextSlot;
+
+	if(slot != 0xffffffff)
+		cmtMap->hitCnt++;
+	else
+	{
+		cmtMap->missCnt++;
+
+		// least recently used translation page is replaced
+		slot = cmtMap->tail;
+		if(cmtMap->cmtEntry[slot].dieNo != 0xff)
+		{
+			if(cmtMap->cmtEntry[slot].dirty)
+				WriteTransPage(slot);
+			cmtMap->slotIndex[cmtMap->cmtEntry[slot].dieNo][cmtMap->cmtEntry[slot].transPageNo] = 0xffffffff;
+		}
+
+		if(gtdMap->gtdEntry[dieNo][transPageNo] != 0xffffffff)
+		{
+			WaitWayFree(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM);
+			IoRead(dieNo, IO_CLASS_META, gtdMap->gtdEntry[dieNo][transPageNo], MAP_CACHE_ADDR + slot*PAGE_SIZE);
+			WaitWayFree(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM);
+		}
+		else
+			memset((u8*)(MAP_CACHE_ADDR + slot*PAGE_SIZE), 0xff, PAGE_SIZE);	// translation page never written, all unmapped
+
+		cmtMap->cmtEntry[slot].dieNo = dieNo;
+		cmtMap->cmtEntry[slot].transPageNo = transPageNo;
+		cmtMap->cmtEntry[slot].dirty = 0;
+		cmtMap->slotIndex[dieNo][transPageNo] = slot;
+	}
+
+	// move to the head of LRU list
+	if(slot != cmtMap->head)
+	{
+		prevSlot = cmtMap->cmtEntry[slot].prevSlot;
+		nextSlot = cmtMap->cmtEntry[slot].nextSlot;
+
+		cmtMap->cmtEntry[prevSlot].nextSlot = nextSlot;
+		if(nextSlot != 0xffffffff)
+			cmtMap->cmtEntry[nextSlot].prevSlot = prevSlot;
+		else
+			cmtMap->tail = prevSlot;
+
+		cmtMap->cmtEntry[slot].prevSlot = 0xffffffff;
+		cmtMap->cmtEntry[slot].nextSlot = cmtMap->head;
+		cmtMap->cmtEntry[cmtMap->head].prevSlot = slot;
+		cmtMap->head = slot;
+	}
+
+	return MAP_CACHE_ADDR + slot*PAGE_SIZE;
+}
+
+void WriteTransPage(u32 slot)
+{
+	cmtMap = (struct cmtArray*)(CMT_ADDR);
+	gtdMap = (struct gtdArray*)(GTD_ADDR);
+	transBlock = (struct tbArray*)(TRANS_MAP_ADDR);
+
+	u32 dieNo = cmtMap->cmtEntry[slot].dieNo;
+	u32 transPageNo = cmtMap->cmtEntry[slot].transPageNo;
+	u32 ppn = AllocTransPage(dieNo);
+	u32 oldPpn = gtdMap->gtdEntry[dieNo][transPageNo];	// read after allocation, compaction can move it
+
+	WaitWayFree(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM);
+	IoProgram(dieNo, IO_CLASS_META, ppn, MAP_CACHE_ADDR + slot*PAGE_SIZE);
+	WaitWayFree(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM);	// slot is reused right after
+
+	// old translation page becomes invalid
+	if(oldPpn != 0xffffffff)
+	{
+		int i;
+		for(i=0 ; i<TRANS_BLOCK_NUM_PER_DIE ; i++)
+			if(transBlock->tbEntry[dieNo].block[i] == oldPpn / PAGE_NUM_PER_BLOCK)
+				transBlock->tbEntry[dieNo].validCnt[i]--;
+	}
+
+	gtdMap->gtdEntry[dieNo][transPageNo] = ppn;
+	transBlock->tbEntry[dieNo].validCnt[transBlock->tbEntry[dieNo].activeBlock]++;
+	cmtMap->cmtEntry[slot].dirty = 0;
+}
+
+u32 AllocTransPage(u32 dieNo)
+{
+	transBlock = (struct tbArray*)(TRANS_MAP_ADDR);
+
+	struct tbEntry* tb = &transBlock->tbEntry[dieNo];
+	u32 i, emptyBlock;
+	int emptyCnt;
+
+	if(tb->currentPage[tb->activeBlock] == PAGE_NUM_PER_BLOCK)
+	{
+		emptyCnt = 0;
+		emptyBlock = 0;
+		for(i=0 ; i<TRANS_BLOCK_NUM_PER_DIE ; i++)
+			if((i != tb->activeBlock) && (tb->currentPage[i] == 0))
+			{
+				emptyCnt++;
+				emptyBlock = i;
+			}
+
+		// the last empty block is kept as a spare for compaction
+		if(emptyCnt > 1)
+			tb->activeBlock = emptyBlock;
+		else
+			CompactTransBlock(dieNo);
+	}
+
+	return tb->block[tb->activeBlock] * PAGE_NUM_PER_BLOCK + tb->currentPage[tb->activeBlock]++;
+}
+
+void CompactTransBlock(u32 dieNo)
+{
+	blockMap = (struct bmArray*)(BLOCK_MAP_ADDR);
+	gtdMap = (struct gtdArray*)(GTD_ADDR);
+	transBlock = (struct tbArray*)(TRANS_MAP_ADDR);
+
+	struct tbEntry* tb = &transBlock->tbEntry[dieNo];
+	int i, victim, spare;
+	u32 ppn;
+
+	// victim has the fewest valid translation pages, the spare block receives them
+	victim = -1;
+	spare = -1;
+	for(i=0 ; i<TRANS_BLOCK_NUM_PER_DIE ; i++)
+	{
+		if(tb->currentPage[i] == 0)
+			spare = i;
+		else if((victim == -1) || (tb->validCnt[i] < tb->validCnt[victim]))
+			victim = i;
+	}
+	assert((victim != -1) && (spare != -1));
+
+	tb->activeBlock = spare;
+	for(i=0 ; i<TRANS_PAGE_NUM_PER_DIE ; i++)
+		if((gtdMap->gtdEntry[dieNo][i] != 0xffffffff) && (gtdMap->gtdEntry[dieNo][i] / PAGE_NUM_PER_BLOCK == tb->block[victim]))
+		{
+			ppn = tb->block[spare] * PAGE_NUM_PER_BLOCK + tb->currentPage[spare]++;
+
+			WaitWayFree(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM);
+			IoRead(dieNo, IO_CLASS_META, gtdMap->gtdEntry[dieNo][i], TRANS_BUFFER_ADDR);
+			WaitWayFree(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM);
+			IoProgram(dieNo, IO_CLASS_META, ppn, TRANS_BUFFER_ADDR);
+
+			gtdMap->gtdEntry[dieNo][i] = ppn;
+			tb->validCnt[spare]++;
+		}
+
+	tb->validCnt[victim] = 0;
+	tb->currentPage[victim] = 0;
+
+	blockMap->bmEntry[dieNo][tb->block[victim]].eraseCnt++;
+	SmartErase(dieNo, tb->block[victim]);
+	WaitWayFree(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM);
+	IoErase(dieNo, IO_CLASS_META, tb->block[victim]);
+}
+
+#endif
+
+void FlushMapCache()
+{
+#if MAP_CACHE_ENABLE
+	cmtMap = (struct cmtArray*)(CMT_ADDR);
+
+	int i;
+	for(i=0 ; i<MAP_CACHE_SLOT_NUM ; i++)
+		if((cmtMap->cmtEntry[i].dieNo != 0xff) && cmtMap->cmtEntry[i].dirty)
+			WriteTransPage(i);
+
+	xil_printf("[ Map cache flush is done. hit: %d, miss: %d ]\r\n", cmtMap->hitCnt, cmtMap->missCnt);
+#endif
+}
@@ -0,0 +1,111 @@
+//////////////////////////////////////////////////////////////////////////////////
+// map_cache.h for Cosmos OpenSSD
+// Copyright (c) 2014 Hanyang University ENC Lab.
+// Contributed by Yong Ho Song <yhsong@enc.hanyang.ac.kr>
+//                Gyeongyong Lee <gylee@enc.hanyang.ac.kr>
+//			      Jaewook Kwak <jwkwak@enc.hanyang.ac.kr>
+//
+// This file is part of Cosmos OpenSSD.
+//
+// Cosmos OpenSSD is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3, or (at your option)
+// any later version.
+//
+// Cosmos OpenSSD is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Cosmos OpenSSD; see the file COPYING.
+// If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////
+// Company: ENC Lab. <http://enc.hanyang.ac.kr>
+// Engineer: Gyeongyong Lee <gylee@enc.hanyang.ac.kr>
+//			 Jaewook Kwak <jwkwak@enc.hanyang.ac.kr>
+//
+// Project Name: Cosmos OpenSSD
+// Design Name: Greedy FTL
+// Module Name: Mapping Table Cache
+// File Name: map_cache.h
+//
+// Version: v1.0.0
+//
+// Description:
+//   - define data structure of L2P table and cached mapping table
+//////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////
+// Revision History:
+//
+// * v1.0.0
+//   - First draft
+//////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MAP_CACHE_H_
+#define MAP_CACHE_H_
+
+#include "xil_types.h"
+#include "ftl.h"
+
+// L2P table held in DRAM as a whole
+struct l2pArray {
+	u32 l2pEntry[DIE_NUM][SUB_PAGE_NUM_PER_DIE];	// physical sub-page of each logical sub-page
+};
+
+// cached mapping table, a translation page holds L2P entries of TRANS_ENTRY_NUM_PER_PAGE logical sub-pages
+struct cmtEntry {
+	u32 dieNo		: 8;	// 0xff for an empty slot
+	u32 dirty		: 1;
+	u32 transPageNo	: 23;
+	u32 prevSlot;
+	u32 nextSlot;
+};
+
+struct cmtArray {
+	struct cmtEntry cmtEntry[MAP_CACHE_SLOT_NUM];
+	u32 slotIndex[DIE_NUM][TRANS_PAGE_NUM_PER_DIE];	// slot caching each translation page
+	u32 head;	// most recently used slot
+	u32 tail;	// least recently used slot
+	u32 hitCnt;
+	u32 missCnt;
+};
+
+// global translation directory, physical page of each translation page
+struct gtdArray {
+	u32 gtdEntry[DIE_NUM][TRANS_PAGE_NUM_PER_DIE];
+};
+
+// blocks dedicated to translation pages, written as a log
+struct tbEntry {
+	u32 block[TRANS_BLOCK_NUM_PER_DIE];
+	u32 validCnt[TRANS_BLOCK_NUM_PER_DIE];
+	u32 currentPage[TRANS_BLOCK_NUM_PER_DIE];	// number of programmed pages
+	u32 activeBlock;	// index of the block being written
+};
+
+struct tbArray {
+	struct tbEntry tbEntry[DIE_NUM];
+};
+
+struct l2pArray* l2pMap;
+struct cmtArray* cmtMap;
+struct gtdArray* gtdMap;
+struct tbArray* transBlock;
+
+void InitMapCache();
+void InitTransBlock();
+
+u32 GetL2P(u32 dieNo, u32 dieLpn);
+void SetL2P(u32 dieNo, u32 dieLpn, u32 ppn);
+
+u32 LoadTransPage(u32 dieNo, u32 transPageNo);
+void WriteTransPage(u32 slot);
+u32 AllocTransPage(u32 dieNo);
+void CompactTransBlock(u32 dieNo);
+void FlushMapCache();
+
+#endif /* MAP_CACHE_H_ */
@@ -0,0 +1 @@
+pagemap.h
\ No newline at end of file
@@ -32,7 +32,7 @@
 // Module Name: Page Mapping
 // File Name: page_map.c
 //
-// Version: v2.4.0
+// Version: v2.25.0
 //
 // Description:
 //   - initialize map tables
@@ -42,6 +42,102 @@
 //////////////////////////////////////////////////////////////////////////////////
 // Revision History:
 //
+// * v2.25.0
+//   - NAND commands are issued through the I/O scheduler, host write programs are queued on busy dies
+//   - dies of a read request are held from queued programs until the request is done
+//
+// * v2.24.7
+//   - P2L entries are kept for open blocks only when the mapping table is cached, closed blocks give them from their page map page
+//
+// * v2.24.6
+//   - page map buffer of a die is refilled only after the die has finished its last program
+//
+// * v2.24.5
+//   - sub-pages beyond the capacity of the last boot are not remapped from page maps of blocks at recovery
+//
+// * v2.24.4
+//   - a GC step waits for the program of the last step from GC buffers shared by all dies
+//
+// * v2.24.3
+//   - fingerprint of a written page is declared only when DEDUP_ENABLE is set
+//
+// * v2.24.2
+//   - current block is compared with the signed block counter through an explicit cast
+//
+// * v2.24.1
+//   - variables used only without cached mapping table are declared under MAP_CACHE_ENABLE
+//
+// * v2.24.0
+//   - over-provisioned blocks of each die are set at run time and left out of the exported capacity
+//   - background GC keeps more free blocks as over-provisioning grows
+//
+// * v2.23.0
+//   - host writes are throttled by GC debt growing as free blocks of the die run out
+//
+// * v2.22.0
+//   - GC victim is migrated in steps, by host programs and while idle when a die runs short of free blocks
+//   - GC waiting for a whole victim is left to host writes finding no free block
+//
+// * v2.21.0
+//   - host reads suspend a program or erase of their die when SUSPEND_ENABLE is set
+//
+// * v2.20.0
+//   - page map page of a block is programmed without waiting for it, page map pages of all dies overlap
+//   - open blocks are closed at shutdown stream by stream across all dies in parallel
+//
+// * v2.19.0
+//   - compressible full pages are packed into container pages when COMP_ENABLE is set
+//
+// * v2.18.0
+//   - full page identical to a programmed page of the die shares it through a dedup entry when DEDUP_ENABLE is set
+//   - L2P entries of zero-mapped and shared sub-pages are saved at shutdown as extents
+//
+// * v2.17.0
+//   - all-zero writes are mapped to ZERO_4BYTE without program, reads of them and of unmapped pages come from zero buffer
+//   - zero mapping is saved at shutdown as extents after meta data
+//
+// * v2.16.0
+//   - page data and page map are copied and inspected by data kernels
+//   - page map page carries CRC32C checked at recovery
+//
+// * v2.15.0
+//   - GC victim list is found by CLZ on bitmap of non-empty lists instead of scanning all lists
+//
+// * v2.14.0
+//   - host writes are split into hot and cold streams by data age, GC migrates into its own stream
+//   - open blocks join GC victim lists when they are closed
+//
+// * v2.13.0
+//   - free blocks are kept in per-die lists sorted by erase count, allocation takes the list head
+//
+// * v2.12.0
+//   - the least worn free block is allocated for wear leveling
+//
+// * v2.11.0
+//   - update SMART counters on block allocation, erase and GC migration
+//
+// * v2.10.0
+//   - host data lands in buffers of write buffer pool and is programmed without copy
+//   - whole sub-pages are transferred from host directly into the packing buffer
+//
+// * v2.9.0
+//   - host DMA of each page is overlapped with NAND operations of the other pages
+//
+// * v2.8.0
+//   - read requests are served from read-ahead buffer and trigger prefetch of sequential streams
+//
+// * v2.7.0
+//   - validity of physical sub-pages is kept in per-block bitmaps scanned word-wise by GC
+//
+// * v2.6.0
+//   - L2P table is accessed through GetL2P() and SetL2P() to support cached mapping table
+//   - page map recovery validates physical sub-pages against the flushed translation pages
+//
+// * v2.5.0
+//   - sub-page (4KB) mapping granularity to avoid read-modify-write of half page writes
+//   - page buffer is replaced with per-die packing buffers gathering sub-page writes
+//   - a physical sub-page becomes valid when it is programmed
+//
 // * v2.4.0
 //   - support channel/way interleaving between different write requests
 //
@@ -78,24 +174,19 @@
 #include <string.h>
 
 u32 BAD_BLOCK_SIZE;
+u32 OP_BLOCK_NUM;	// over-provisioned blocks of each die since boot
 
 void InitPageMap()
 {
 	pageMap = (struct pmArray*)(PAGE_MAP_ADDR);
+	validMap = (struct vmArray*)(VALID_MAP_ADDR);
 
 //	xil_printf("PAGE_MAP_ADDR : %8x\r\n", PAGE_MAP_ADDR);
 
-	// page status initialization, allows lpn, ppn access
-	int i, j;
-	for(i=0 ; i<DIE_NUM ; i++)
-	{
-		for(j=0 ; j<PAGE_NUM_PER_DIE ; j++)
-		{
-			pageMap->pmEntry[i][j].ppn = 0xffffffff;
-			pageMap->pmEntry[i][j].valid = 1;
-			pageMap->pmEntry[i][j].lpn = 0x7fffffff;
-		}
-	}
+	// page status initialization, allows lpn access
+	memset(pageMap, 0xff, sizeof(struct pmArray));
+	memset(validMap, 0, sizeof(struct vmArray));
+	memset((u8*)ZERO_BUFFER_ADDR, 0, PAGE_SIZE);
 
 	xil_printf("[ ssd page map initialized. ]\r\n");
 }
@@ -112,11 +203,13 @@ void InitBlockMap()
 		for(j=0 ; j<DIE_NUM ; j++)
 		{
 			blockMap->bmEntry[j][i].free = 1;
+			blockMap->bmEntry[j][i].open = 0;
 			blockMap->bmEntry[j][i].eraseCnt = 0;
 			blockMap->bmEntry[j][i].invalidPageCnt = 0;
 			blockMap->bmEntry[j][i].currentPage = 0x0;
-			blockMap->bmEntry[j][i].prevBlock = 0xffffffff;
-			blockMap->bmEntry[j][i].nextBlock = 0xffffffff;
+			blockMap->bmEntry[j][i].prevBlock = BLOCK_NONE;
+			blockMap->bmEntry[j][i].nextBlock = BLOCK_NONE;
+			blockMap->bmEntry[j][i].writeSeq = 0;
 		}
 	}
 
@@ -126,7 +219,7 @@ void InitBlockMap()
 			{
 				// initial block erase
 				WaitWayFree(j % CHANNEL_NUM, j / CHANNEL_NUM);
-				SsdErase(j % CHANNEL_NUM, j / CHANNEL_NUM, i);
+				IoErase(j, IO_CLASS_META, i);
 			}
 
 
@@ -165,7 +258,7 @@ void CheckBadBlock()
 	tempBuffer = RAM_DISK_BASE_ADDR;
 	while(loop > 0)
 	{
-		SsdRead(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM, diePpn, tempBuffer);
+		IoRead(dieNo, IO_CLASS_META, diePpn, tempBuffer);
 		WaitWayFree(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM);
 
 		diePpn++;
@@ -183,7 +276,7 @@ void CheckBadBlock()
 			{
 				blockMap->bmEntry[dieNo][blockNo].bad = 0;
 
-				SsdRead(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM, (blockNo*PAGE_NUM_PER_BLOCK+1), RAM_DISK_BASE_ADDR);
+				IoRead(dieNo, IO_CLASS_META, (blockNo*PAGE_NUM_PER_BLOCK+1), RAM_DISK_BASE_ADDR);
 				WaitWayFree(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM);
 
 				if(CountBits(*markPointer)<4)
@@ -202,14 +295,14 @@ void CheckBadBlock()
 		diePpn = METADATA_BLOCK_PPN / DIE_NUM;
 		blockNo = diePpn / PAGE_NUM_PER_BLOCK;
 
-		SsdErase(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM, blockNo);
+		IoErase(dieNo, IO_CLASS_META, blockNo);
 		WaitWayFree(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM);
 
 		tempBuffer = GC_BUFFER_ADDR;
 		while(loop>0)
 		{
 			WaitWayFree(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM);
-			SsdProgram(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM, diePpn, tempBuffer);
+			IoProgram(dieNo, IO_CLASS_META, diePpn, tempBuffer);
 			diePpn++;
 			tempBuffer += PAGE_SIZE;
 			loop -= PAGE_SIZE;
@@ -238,33 +331,34 @@ void CheckBadBlock()
 	BAD_BLOCK_SIZE = badBlockCount * BLOCK_SIZE_MB;
 }
 
-int CountBits(u8 i)
-{
-	int count;
-	count=0;
-	while(i!=0)
-	{
-		count+=i%2;
-		i/=2;
-	}
-	return count;
-}
 
 
 void InitDieBlock()
 {
 	dieBlock = (struct dieArray*)(DIE_MAP_ADDR);
+	blockMap = (struct bmArray*)(BLOCK_MAP_ADDR);
 
 //	xil_printf("DIE_MAP_ADDR : %8x\r\n", DIE_MAP_ADDR);
 
-	int i;
+	int i, j;
 	for(i=0 ; i<DIE_NUM ; i++)
 	{
+		// hot stream starts at the block allocated by InitBlockMap, the others open a block at their first write
 		if(i==0) // prevent to write at meta data block
-			dieBlock->dieEntry[i].currentBlock = 1;
+			dieBlock->dieEntry[i].currentBlock[STREAM_HOT] = 1;
 		else
-			dieBlock->dieEntry[i].currentBlock = 0;
+			dieBlock->dieEntry[i].currentBlock[STREAM_HOT] = 0;
+		blockMap->bmEntry[i][dieBlock->dieEntry[i].currentBlock[STREAM_HOT]].open = 1;
+		for(j=STREAM_HOT+1 ; j<STREAM_NUM ; j++)
+			dieBlock->dieEntry[i].currentBlock[j] = 0xffffffff;
 		dieBlock->dieEntry[i].freeBlock = BLOCK_NUM_PER_DIE - 1;
+
+		// all blocks have the same erase count at format
+		dieBlock->dieEntry[i].freeListHead = BLOCK_NONE;
+		dieBlock->dieEntry[i].freeListTail = BLOCK_NONE;
+		for(j=0 ; j<BLOCK_NUM_PER_DIE ; j++)
+			if(blockMap->bmEntry[i][j].free && !blockMap->bmEntry[i][j].bad)
+				PutFreeBlock(i, j);
 	}
 
 	xil_printf("[ ssd die map initialized. ]\r\n");
@@ -280,11 +374,14 @@ void InitGcMap()
 	int i, j;
 	for(i=0 ; i<DIE_NUM ; i++)
 	{
-		for(j=0 ; j<PAGE_NUM_PER_BLOCK+1 ; j++)
+		for(j=0 ; j<SUB_PAGE_NUM_PER_BLOCK+1 ; j++)
 		{
-			gcMap->gcEntry[i][j].head = 0xffffffff;
-			gcMap->gcEntry[i][j].tail = 0xffffffff;
+			gcMap->gcEntry[i][j].head = BLOCK_NONE;
+			gcMap->gcEntry[i][j].tail = BLOCK_NONE;
 		}
+		for(j=0 ; j<GC_BITMAP_WORD_NUM ; j++)
+			gcMap->bitmap[i][j] = 0;
+		gcMap->summary[i] = 0;
 	}
 
 	xil_printf("[ ssd gc map initialized. ]\r\n");
@@ -301,43 +398,137 @@ void InitCiMap()
 	xil_printf("[ ssd ci map initialized. ]\r\n");
 }
 
+void InitPackBuf()
+{
+	packBuf = (struct pbArray*)(PACK_MAP_ADDR);
+
+	int i, j, k;
+	for(i=0 ; i<DIE_NUM ; i++)
+		for(k=0 ; k<STREAM_HOST_NUM ; k++)
+		{
+			for(j=0 ; j<SUB_PAGE_NUM_PER_PAGE ; j++)
+				packBuf->pbEntry[i][k].lpn[j] = 0xffffffff;
+			packBuf->pbEntry[i][k].slotCnt = 0;
+			packBuf->pbEntry[i][k].bufAddr = 0xffffffff;
+		}
+
+	xil_printf("[ ssd packing buffer initialized. ]\r\n");
+}
+
+void InitWriteBuf()
+{
+	writeBuf = (struct wbArray*)(WRITE_MAP_ADDR);
+
+	int i;
+	for(i=0 ; i<WRITE_BUFFER_NUM ; i++)
+		writeBuf->freeBuf[i] = WRITE_BUFFER_ADDR + i*PAGE_SIZE;
+	writeBuf->freeCnt = WRITE_BUFFER_NUM;
+
+	for(i=0 ; i<DIE_NUM ; i++)
+		writeBuf->progBuf[i] = 0xffffffff;
+	writeBuf->reclaimDie = 0;
+
+	xil_printf("[ ssd write buffer pool initialized. ]\r\n");
+}
+
 
-int FindFreePage(u32 dieNo)
+int FindFreePage(u32 dieNo, u32 stream)
 {
 	blockMap = (struct bmArray*)(BLOCK_MAP_ADDR);
 	dieBlock = (struct dieArray*)(DIE_MAP_ADDR);
+	ciMap = (struct ciArray*)(CI_ADDR);
+	seqMap = (struct seqArray*)(SEQ_MAP_ADDR);
 
-	if(blockMap->bmEntry[dieNo][dieBlock->dieEntry[dieNo].currentBlock].currentPage == (PAGE_NUM_PER_BLOCK-2)) // last page is a spare for pageMap of current block
-	{
-		PageMapFlushForCurrentBlock(dieNo, GC_BUFFER_ADDR);
+	if(stream != STREAM_GC)
+		GcWriteStep(dieNo);
 
-		dieBlock->dieEntry[dieNo].currentBlock++;
+	u32 blockNo = dieBlock->dieEntry[dieNo].currentBlock[stream];
 
-		int i;
-		for(i=dieBlock->dieEntry[dieNo].currentBlock ; i<(dieBlock->dieEntry[dieNo].currentBlock + BLOCK_NUM_PER_DIE) ; i++)
-		{
-			if((blockMap->bmEntry[dieNo][i % BLOCK_NUM_PER_DIE].free) && (!blockMap->bmEntry[dieNo][i % BLOCK_NUM_PER_DIE].bad))
-			{
-				blockMap->bmEntry[dieNo][i % BLOCK_NUM_PER_DIE].free = 0;
-				dieBlock->dieEntry[dieNo].currentBlock = i % BLOCK_NUM_PER_DIE;
+	if((blockNo != 0xffffffff) && (blockMap->bmEntry[dieNo][blockNo].currentPage == (PAGE_NUM_PER_BLOCK-2))) // last page is a spare for pageMap of current block
+		PageMapFlushForCurrentBlock(dieNo, stream, P2L_BUFFER_ADDR + dieNo*PAGE_SIZE);
 
-//				xil_printf("allocated free block: %4d at %d-%d\r\n", dieBlock->dieEntry[dieNo].currentBlock, dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM);
+	if(dieBlock->dieEntry[dieNo].currentBlock[stream] == 0xffffffff)
+		blockNo = OpenBlock(dieNo, stream);
 
-				return dieBlock->dieEntry[dieNo].currentBlock * PAGE_NUM_PER_BLOCK;
-			}
-		}
+	blockMap->bmEntry[dieNo][blockNo].currentPage++;
+	u32 pageNo = blockMap->bmEntry[dieNo][blockNo].currentPage;
 
-		dieBlock->dieEntry[dieNo].currentBlock = GarbageCollection(dieNo);
+	seqMap->seq[dieNo][stream][pageNo] = ++ciMap->ciEntry[dieNo];
+	if(stream != STREAM_GC)	// data surviving GC is old
+		blockMap->bmEntry[dieNo][blockNo].writeSeq = ciMap->ciEntry[dieNo];
 
-//		xil_printf("allocated free block by GC: %4d at %d-%d\r\n", dieBlock->dieEntry[dieNo].currentBlock, dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM);
+	return blockNo * PAGE_NUM_PER_BLOCK + pageNo;
+}
 
-		return (dieBlock->dieEntry[dieNo].currentBlock * PAGE_NUM_PER_BLOCK) + blockMap->bmEntry[dieNo][dieBlock->dieEntry[dieNo].currentBlock].currentPage;
-	}
-	else
+// host streams wait for GC when no free block is left, GC takes the reserved block instead
+u32 OpenBlock(u32 dieNo, u32 stream)
+{
+	blockMap = (struct bmArray*)(BLOCK_MAP_ADDR);
+	dieBlock = (struct dieArray*)(DIE_MAP_ADDR);
+
+	u32 blockNo = AllocFreeBlock(dieNo);
+
+	if(blockNo == 0xffffffff)
 	{
-		blockMap->bmEntry[dieNo][dieBlock->dieEntry[dieNo].currentBlock].currentPage++;
-		return (dieBlock->dieEntry[dieNo].currentBlock * PAGE_NUM_PER_BLOCK) + blockMap->bmEntry[dieNo][dieBlock->dieEntry[dieNo].currentBlock].currentPage;
+		if(stream == STREAM_GC)
+		{
+			blockNo = dieBlock->dieEntry[dieNo].freeBlock;
+			dieBlock->dieEntry[dieNo].freeBlock = 0xffffffff;
+			assert(blockNo != 0xffffffff);
+		}
+		else
+			while(blockNo == 0xffffffff)
+			{
+				GarbageCollection(dieNo);
+				blockNo = AllocFreeBlock(dieNo);
+			}
 	}
+
+//	xil_printf("allocated free block: %4d at %d-%d for stream %d\r\n", blockNo, dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM, stream);
+
+	blockMap->bmEntry[dieNo][blockNo].open = 1;
+	blockMap->bmEntry[dieNo][blockNo].currentPage = 0xffff;	// the first page is 0 after increment
+	blockMap->bmEntry[dieNo][blockNo].writeSeq = 0;
+	dieBlock->dieEntry[dieNo].currentBlock[stream] = blockNo;
+#if MAP_CACHE_ENABLE
+	pageMap = (struct pmArray*)(PAGE_MAP_ADDR);
+	memset(pageMap->lpn[dieNo][stream], 0xff, sizeof(u32) * SUB_PAGE_NUM_PER_BLOCK);
+#endif
+
+	return blockNo;
+}
+
+// called when page map is programmed at the last page, the block becomes a GC candidate
+void CloseBlock(u32 dieNo, u32 stream)
+{
+	blockMap = (struct bmArray*)(BLOCK_MAP_ADDR);
+	dieBlock = (struct dieArray*)(DIE_MAP_ADDR);
+
+	u32 blockNo = dieBlock->dieEntry[dieNo].currentBlock[stream];
+
+	blockMap->bmEntry[dieNo][blockNo].open = 0;
+	if(blockMap->bmEntry[dieNo][blockNo].invalidPageCnt)
+		InsertGcList(dieNo, blockNo);
+
+	dieBlock->dieEntry[dieNo].currentBlock[stream] = 0xffffffff;
+}
+
+// overwrite of young data is hot, first write and overwrite of old data are cold
+u32 ClassifyStream(u32 dieNo, u32 dieLpn)
+{
+	blockMap = (struct bmArray*)(BLOCK_MAP_ADDR);
+	ciMap = (struct ciArray*)(CI_ADDR);
+
+	u32 ppn = GetPpn(dieNo, dieLpn);
+
+	if(ppn == BUFFERED_4BYTE)
+		return STREAM_HOT;
+	if((ppn >= ZERO_4BYTE) || IS_COMP(ppn))	// unmapped, zero-mapped or compressed
+		return STREAM_COLD;
+
+	if(ciMap->ciEntry[dieNo] - blockMap->bmEntry[dieNo][ppn / SUB_PAGE_NUM_PER_BLOCK].writeSeq < HOT_DATA_AGE)
+		return STREAM_HOT;
+	return STREAM_COLD;
 }
 
 int PrePmRead(P_HOST_CMD hostCmd, u32 bufferAddr)
@@ -346,110 +537,150 @@ int PrePmRead(P_HOST_CMD hostCmd, u32 bufferAddr)
 	u32 dieNo;
 	u32 dieLpn;
 
+	u32 startSect = hostCmd->reqInfo.CurSect;
+	u32 endSect = hostCmd->reqInfo.CurSect + hostCmd->reqInfo.ReqSect;
+	u32 bufLpn = (startSect / SECTOR_NUM_PER_PAGE) * SUB_PAGE_NUM_PER_PAGE;	// logical sub-page at bufferAddr
+
 	pageMap = (struct pmArray*)(PAGE_MAP_ADDR);
-	lpn = hostCmd->reqInfo.CurSect / SECTOR_NUM_PER_PAGE;
 
-	if (lpn != pageBufLpn)
+	// only sub-pages partially written by the request are read
+	lpn = startSect / SECTOR_NUM_PER_SUB_PAGE;
+	if(((startSect % SECTOR_NUM_PER_SUB_PAGE) != 0)
+			|| (((endSect % SECTOR_NUM_PER_SUB_PAGE) != 0) && ((endSect / SECTOR_NUM_PER_SUB_PAGE) == lpn)))
 	{
-		FlushPageBuf(pageBufLpn, bufferAddr);
-
-		if((((hostCmd->reqInfo.CurSect)%SECTOR_NUM_PER_PAGE) != 0)
-					|| ((hostCmd->reqInfo.CurSect / SECTOR_NUM_PER_PAGE) == (((hostCmd->reqInfo.CurSect)+(hostCmd->reqInfo.ReqSect))/SECTOR_NUM_PER_PAGE)))
-		{
-			dieNo = lpn % DIE_NUM;
-			dieLpn = lpn / DIE_NUM;
+		dieNo = (lpn / SUB_PAGE_NUM_PER_PAGE) % DIE_NUM;
+		dieLpn = (lpn / SUB_PAGE_NUM_PER_PAGE) / DIE_NUM * SUB_PAGE_NUM_PER_PAGE + lpn % SUB_PAGE_NUM_PER_PAGE;
 
-			if(pageMap->pmEntry[dieNo][dieLpn].ppn != 0xffffffff)
-			{
-//				xil_printf("PrePmRead pdie, ppn = %d, %d\r\n", dieNo, pageMap->pmEntry[dieNo][dieLpn].ppn);
+		ReadSubPage(dieNo, dieLpn, bufferAddr + (lpn - bufLpn) * SUB_PAGE_SIZE);
+	}
 
-				WaitWayFree(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM);
-				SsdRead(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM, pageMap->pmEntry[dieNo][dieLpn].ppn, bufferAddr);
-				WaitWayFree(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM);
+	if(((endSect % SECTOR_NUM_PER_SUB_PAGE) != 0) && ((endSect / SECTOR_NUM_PER_SUB_PAGE) != (startSect / SECTOR_NUM_PER_SUB_PAGE)))
+	{
+		lpn = endSect / SECTOR_NUM_PER_SUB_PAGE;
+		dieNo = (lpn / SUB_PAGE_NUM_PER_PAGE) % DIE_NUM;
+		dieLpn = (lpn / SUB_PAGE_NUM_PER_PAGE) / DIE_NUM * SUB_PAGE_NUM_PER_PAGE + lpn % SUB_PAGE_NUM_PER_PAGE;
 
-				pageBufLpn = lpn;
-			}
-		}
+		ReadSubPage(dieNo, dieLpn, bufferAddr + (lpn - bufLpn) * SUB_PAGE_SIZE);
 	}
 
-	if(((((hostCmd->reqInfo.CurSect)+(hostCmd->reqInfo.ReqSect))% SECTOR_NUM_PER_PAGE) != 0)
-			&& ((hostCmd->reqInfo.CurSect / SECTOR_NUM_PER_PAGE) != (((hostCmd->reqInfo.CurSect)+(hostCmd->reqInfo.ReqSect))/SECTOR_NUM_PER_PAGE)))
+	return 0;
+}
+
+int PmRead(P_HOST_CMD hostCmd, u32 bufferAddr)
+{
+	u32 startSect = hostCmd->reqInfo.CurSect;
+	u32 endSect = hostCmd->reqInfo.CurSect + hostCmd->reqInfo.ReqSect;
+	u32 startLpn = startSect / SECTOR_NUM_PER_PAGE;
+	u32 pageNum = (endSect + SECTOR_NUM_PER_PAGE - 1) / SECTOR_NUM_PER_PAGE - startLpn;
+
+	u32 issuedPage, donePage;
+	u32 dieNo;
+	u32 dmaStartSect, dmaEndSect;
+	u32 pageAddr[DIE_NUM];	// where the data of issued pages lies, the buffer or the zero buffer
+	u32 doneAddr;
+	DMA_CURSOR dmaCursor;
+
+	// dies of the request read before host write programs queued on them
+	for(issuedPage=0 ; (issuedPage<pageNum) && (issuedPage<DIE_NUM) ; issuedPage++)
+		IoHoldRead((startLpn + issuedPage) % DIE_NUM);
+
+	// reads are issued ahead up to one page per die
+	for(issuedPage=0 ; (issuedPage<pageNum) && (issuedPage<DIE_NUM) ; issuedPage++)
+		pageAddr[issuedPage % DIE_NUM] = PmReadPage(startLpn + issuedPage, bufferAddr + issuedPage*PAGE_SIZE, startSect, endSect);
+
+	DmaStart(hostCmd, &dmaCursor);
+
+	// each page is transferred to host as soon as its die completes the read
+	for(donePage=0 ; donePage<pageNum ; donePage++)
 	{
-		lpn = ((hostCmd->reqInfo.CurSect)+(hostCmd->reqInfo.ReqSect))/SECTOR_NUM_PER_PAGE;
-		dieNo = lpn % DIE_NUM;
-		dieLpn = lpn / DIE_NUM;
+		dieNo = (startLpn + donePage) % DIE_NUM;
+		doneAddr = pageAddr[donePage % DIE_NUM];
+		if(doneAddr != ZERO_BUFFER_ADDR)
+			WaitWayRead(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM);
 
-		if(pageMap->pmEntry[dieNo][dieLpn].ppn != 0xffffffff)
+		// the die reads the next page of the request during the transfer
+		if(issuedPage < pageNum)
 		{
+			pageAddr[issuedPage % DIE_NUM] = PmReadPage(startLpn + issuedPage, bufferAddr + issuedPage*PAGE_SIZE, startSect, endSect);
+			issuedPage++;
+		}
 
-//			xil_printf("PrePmRead pdie, ppn = %d, %d\r\n", dieNo, pageMap->pmEntry[dieNo][dieLpn].ppn);
+		dmaStartSect = (startLpn + donePage) * SECTOR_NUM_PER_PAGE;
+		dmaEndSect = dmaStartSect + SECTOR_NUM_PER_PAGE;
+		if(dmaStartSect < startSect)
+			dmaStartSect = startSect;
+		if(dmaEndSect > endSect)
+			dmaEndSect = endSect;
 
-			WaitWayFree(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM);
-			SsdRead(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM, pageMap->pmEntry[dieNo][dieLpn].ppn,
-					bufferAddr + ((((hostCmd->reqInfo.CurSect)% SECTOR_NUM_PER_PAGE) + hostCmd->reqInfo.ReqSect)/SECTOR_NUM_PER_PAGE*PAGE_SIZE));
-			WaitWayFree(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM);
-		}
+		DmaTransfer(hostCmd, &dmaCursor, doneAddr + (dmaStartSect % SECTOR_NUM_PER_PAGE)*SECTOR_SIZE,
+					(dmaEndSect - dmaStartSect) * SECTOR_SIZE, DMA_DEVICE_TO_HOST);
+
+		// other dies program what is queued on them meanwhile
+		IoDispatch();
 	}
 
+	// queued programs go before prefetch, which is issued after the requested pages
+	IoReleaseRead();
+	ReadAhead(hostCmd);
+
 	return 0;
 }
 
-int PmRead(P_HOST_CMD hostCmd, u32 bufferAddr)
+// returns the address holding the data of the page, zero buffer if no sub-page has data
+u32 PmReadPage(u32 lpn, u32 tempBuffer, u32 startSect, u32 endSect)
 {
-	u32 tempBuffer = bufferAddr;
-
-	u32 lpn = hostCmd->reqInfo.CurSect / SECTOR_NUM_PER_PAGE;
-	int loop = (hostCmd->reqInfo.CurSect % SECTOR_NUM_PER_PAGE) + hostCmd->reqInfo.ReqSect;
-
+	u32 subSect;
 	u32 dieNo;
 	u32 dieLpn;
+	u32 ppn;
+	int i;
 
-	pageMap = (struct pmArray*)(PAGE_MAP_ADDR);
+	if(ReadAheadHit(lpn, tempBuffer))
+		return tempBuffer;
 
-	if (lpn == pageBufLpn)
+	dieNo = lpn % DIE_NUM;
+	dieLpn = lpn / DIE_NUM * SUB_PAGE_NUM_PER_PAGE;
+	ppn = GetPpn(dieNo, dieLpn);
+
+	// unmapped and zero-mapped pages are transferred from zero buffer without NAND read
+	for(i=0 ; i<SUB_PAGE_NUM_PER_PAGE ; i++)
+		if((GetL2P(dieNo, dieLpn + i) != ZERO_4BYTE) && (GetL2P(dieNo, dieLpn + i) != 0xffffffff))
+			break;
+	if(i == SUB_PAGE_NUM_PER_PAGE)
+		return ZERO_BUFFER_ADDR;
+
+	// check whether all sub-pages lie in order in one physical page or one compressed page
+	i = 0;
+	if((ppn < ZERO_4BYTE) && ((ppn % SUB_PAGE_NUM_PER_PAGE) == 0))
+		for(i=1 ; (i<SUB_PAGE_NUM_PER_PAGE) && (GetPpn(dieNo, dieLpn + i) == ppn + i) ; i++);
+
+	if((i == SUB_PAGE_NUM_PER_PAGE) && IS_COMP(ppn))
 	{
-		lpn++;
-		tempBuffer += PAGE_SIZE;
-		loop -= SECTOR_NUM_PER_PAGE;
+		ReadCompPage(dieNo, ppn, tempBuffer);
+		return tempBuffer;
 	}
-	else
-	{
-		dieNo = lpn % DIE_NUM;
-		dieLpn = lpn / DIE_NUM;
 
-		if (pageMap->pmEntry[dieNo][dieLpn].ppn != 0xffffffff)
-		{
-			FlushPageBuf(pageBufLpn, bufferAddr);
-			pageBufLpn = lpn;
-		}
-	}
+	//		xil_printf("requested read lpn = %d\r\n", lpn);
+	//		xil_printf("read pdie, ppn = %d, %d\r\n", dieNo, ppn);
 
-	while (loop > 0)
+	if (i == SUB_PAGE_NUM_PER_PAGE)
 	{
-		dieNo = lpn % DIE_NUM;
-		dieLpn = lpn / DIE_NUM;
+		//			xil_printf("read at (%d, %2d, %4x)\r\n", dieNo%CHANNEL_NUM, dieNo/CHANNEL_NUM, ppn / SUB_PAGE_NUM_PER_PAGE);
 
-		//		xil_printf("requested read lpn = %d\r\n", lpn);
-		//		xil_printf("read pdie, ppn = %d, %d\r\n", dieNo, pageMap->pmEntry[dieNo][dieLpn].ppn);
-
-		if (pageMap->pmEntry[dieNo][dieLpn].ppn != 0xffffffff)
+		IoRead(dieNo, IO_CLASS_HOST_READ, ppn / SUB_PAGE_NUM_PER_PAGE, tempBuffer);
+	}
+	else
+	{
+		// sub-pages scattered over physical pages or packing buffer are gathered one by one
+		for(i=0 ; i<SUB_PAGE_NUM_PER_PAGE ; i++)
 		{
-			//			xil_printf("read at (%d, %2d, %4x)\r\n", dieNo%CHANNEL_NUM, dieNo/CHANNEL_NUM, pageMap->pmEntry[dieNo][dieLpn].ppn);
-
-			WaitWayFree(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM);
-			SsdRead(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM, pageMap->pmEntry[dieNo][dieLpn].ppn, tempBuffer);
+			subSect = lpn * SECTOR_NUM_PER_PAGE + i * SECTOR_NUM_PER_SUB_PAGE;
+			if((subSect + SECTOR_NUM_PER_SUB_PAGE > startSect) && (subSect < endSect))
+				ReadSubPage(dieNo, dieLpn + i, tempBuffer + i * SUB_PAGE_SIZE);
 		}
-
-		lpn++;
-		tempBuffer += PAGE_SIZE;
-		loop -= SECTOR_NUM_PER_PAGE;
 	}
 
-	int i;
-	for (i = 0; i<DIE_NUM; ++i)
-		WaitWayFree(i%CHANNEL_NUM, i / CHANNEL_NUM);
-
-	return 0;
+	return tempBuffer;
 }
 
 int PmWrite(P_HOST_CMD hostCmd, u32 bufferAddr)
@@ -460,239 +691,979 @@ int PmWrite(P_HOST_CMD hostCmd, u32 bufferAddr)
 	
 	int loop = (hostCmd->reqInfo.CurSect % SECTOR_NUM_PER_PAGE) + hostCmd->reqInfo.ReqSect;
 	
+	u32 startSect = hostCmd->reqInfo.CurSect;
+	u32 endSect = hostCmd->reqInfo.CurSect + hostCmd->reqInfo.ReqSect;
+	u32 pageSect, subSect;
+
 	u32 dieNo;
 	u32 dieLpn;
-	u32 freePageNo;
-	u32 dieBuffer;
+	u32 freePageNo, stream;
+	u32 writeBuffer;
+	u32 lpnList[SUB_PAGE_NUM_PER_PAGE];
+	u32 dmaStartSect, dmaEndSect;
+#if DEDUP_ENABLE
+	u32 crc;
+#endif
+	DMA_CURSOR dmaCursor;
+	int i;
 
 	pageMap = (struct pmArray*)(PAGE_MAP_ADDR);
 
-	// page buffer utilization
-	if (lpn != pageBufLpn)
-		pageBufLpn = lpn;
-
-	UpdateMetaForOverwrite(lpn);
-
-	// pageMap update
-	dieNo = lpn % DIE_NUM;
-	dieLpn = lpn / DIE_NUM;
-	pageMap->pmEntry[dieNo][dieLpn].ppn = 0xffffffff;
-
-	lpn++;
-	tempBuffer += PAGE_SIZE;
-	loop -= SECTOR_NUM_PER_PAGE;
+	DmaStart(hostCmd, &dmaCursor);
 
+	// each page is programmed as soon as its data arrives from host
 	while(loop > 0)
 	{
 		dieNo = lpn % DIE_NUM;
-		dieLpn = lpn / DIE_NUM;
-		freePageNo = FindFreePage(dieNo);
+		dieLpn = lpn / DIE_NUM * SUB_PAGE_NUM_PER_PAGE;
+		pageSect = lpn * SECTOR_NUM_PER_PAGE;
 
-//		xil_printf("free page: %6d(%d, %d, %4d)\r\n", freePageNo, dieNo%CHANNEL_NUM, dieNo/CHANNEL_NUM, freePageNo/PAGE_NUM_PER_BLOCK);
+		ReadAheadInvalidate(lpn);
 
-		WaitWayFree(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM);
-		dieBuffer = DIE_BUFFER_ADDR + dieNo*PAGE_SIZE;
-		memcpy((u32*)dieBuffer,(u32*)tempBuffer,PAGE_SIZE);
-		SsdProgram(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM, freePageNo, dieBuffer);
-		
-		UpdateMetaForOverwrite(lpn);
+		if((pageSect >= startSect) && (pageSect + SECTOR_NUM_PER_PAGE <= endSect))
+		{
+			// whole page lands in a pooled buffer and is programmed from there
+			writeBuffer = AllocWriteBuf();
+			DmaTransfer(hostCmd, &dmaCursor, writeBuffer, PAGE_SIZE, DMA_HOST_TO_DEVICE);
 
-		// pageMap update
-		pageMap->pmEntry[dieNo][dieLpn].ppn = freePageNo;
-		pageMap->pmEntry[dieNo][freePageNo].lpn = dieLpn;
+			// all-zero page is only mapped, no program
+			if(IsDataFilled(writeBuffer, PAGE_SIZE, 0))
+			{
+				FreeWriteBuf(writeBuffer);
+				for(i=0 ; i<SUB_PAGE_NUM_PER_PAGE ; i++)
+					WriteZeroSubPage(dieNo, dieLpn + i);
+
+				lpn++;
+				tempBuffer += PAGE_SIZE;
+				loop -= SECTOR_NUM_PER_PAGE;
+				continue;
+			}
 
-		lpn++;
-		tempBuffer += PAGE_SIZE;
-		loop -= SECTOR_NUM_PER_PAGE;
-	}
+#if DEDUP_ENABLE
+			// duplicate of a programmed page of the die shares it
+			crc = ~Crc32c(CRC32C_INIT, writeBuffer, PAGE_SIZE);
+			if(DedupPage(dieNo, dieLpn, writeBuffer, crc))
+			{
+				FreeWriteBuf(writeBuffer);
 
-	return 0;
-}
+				lpn++;
+				tempBuffer += PAGE_SIZE;
+				loop -= SECTOR_NUM_PER_PAGE;
+				continue;
+			}
+#endif
 
-void EraseBlock(u32 dieNo, u32 blockNo)
-{
-	pageMap = (struct pmArray*)(PAGE_MAP_ADDR);
-	blockMap = (struct bmArray*)(BLOCK_MAP_ADDR);
+#if COMP_ENABLE
+			// compressible page joins the open container of the die
+			if(CompressPage(dieNo, dieLpn, writeBuffer))
+			{
+				FreeWriteBuf(writeBuffer);
 
-	// block map indicated blockNo initialization
-	blockMap->bmEntry[dieNo][blockNo].free = 1;
-	blockMap->bmEntry[dieNo][blockNo].eraseCnt++;
-	blockMap->bmEntry[dieNo][blockNo].invalidPageCnt = 0;
-	blockMap->bmEntry[dieNo][blockNo].currentPage = 0x0;
-	blockMap->bmEntry[dieNo][blockNo].prevBlock = 0xffffffff;
-	blockMap->bmEntry[dieNo][blockNo].nextBlock = 0xffffffff;
+				lpn++;
+				tempBuffer += PAGE_SIZE;
+				loop -= SECTOR_NUM_PER_PAGE;
+				continue;
+			}
+#endif
 
-	int i;
-	for(i=0 ; i<PAGE_NUM_PER_BLOCK ; i++)
-	{
-		pageMap->pmEntry[dieNo][(blockNo * PAGE_NUM_PER_BLOCK) + i].valid = 1;
-		pageMap->pmEntry[dieNo][(blockNo * PAGE_NUM_PER_BLOCK) + i].lpn = 0x7fffffff;
-	}
+			// page is hot if any of its sub-pages is
+			stream = STREAM_COLD;
+			for(i=0 ; i<SUB_PAGE_NUM_PER_PAGE ; i++)
+				if(ClassifyStream(dieNo, dieLpn + i) == STREAM_HOT)
+					stream = STREAM_HOT;
 
-	WaitWayFree(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM);
-	SsdErase(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM, blockNo);
-}
+			for(i=0 ; i<SUB_PAGE_NUM_PER_PAGE ; i++)
+			{
+				UpdateMetaForOverwrite(dieNo, dieLpn + i);
+				lpnList[i] = dieLpn + i;
+			}
 
-u32 GarbageCollection(u32 dieNo)
-{
-//	xil_printf("GC occurs!\r\n");
+			freePageNo = FindFreePage(dieNo, stream);
 
-	pageMap = (struct pmArray*)(PAGE_MAP_ADDR);
-	blockMap = (struct bmArray*)(BLOCK_MAP_ADDR);
-	dieBlock = (struct dieArray*)(DIE_MAP_ADDR);
-	gcMap = (struct gcArray*)(GC_MAP_ADDR);
+//			xil_printf("free page: %6d(%d, %d, %4d)\r\n", freePageNo, dieNo%CHANNEL_NUM, dieNo/CHANNEL_NUM, freePageNo/PAGE_NUM_PER_BLOCK);
 
-	int i;
-	for(i=PAGE_NUM_PER_BLOCK ; i>0 ; i--)
-	{
-		if(gcMap->gcEntry[dieNo][i].head != 0xffffffff)
-		{
-			u32 victimBlock = gcMap->gcEntry[dieNo][i].head;	// GC victim block
+			ProgramWriteBuf(dieNo, freePageNo, writeBuffer);
 
-			// link setting
-			if(blockMap->bmEntry[dieNo][victimBlock].nextBlock != 0xffffffff)
-			{
-				gcMap->gcEntry[dieNo][i].head = blockMap->bmEntry[dieNo][victimBlock].nextBlock;
-				blockMap->bmEntry[dieNo][blockMap->bmEntry[dieNo][victimBlock].nextBlock].prevBlock = 0xffffffff;
-			}
-			else
+			UpdateMetaForProgram(dieNo, freePageNo, lpnList);
+#if DEDUP_ENABLE
+			InsertFingerprint(dieNo, freePageNo * SUB_PAGE_NUM_PER_PAGE, crc);
+#endif
+		}
+		else
+		{
+			// partially written page is packed sub-page by sub-page
+			for(i=0 ; i<SUB_PAGE_NUM_PER_PAGE ; i++)
 			{
-				gcMap->gcEntry[dieNo][i].head = 0xffffffff;
-				gcMap->gcEntry[dieNo][i].tail = 0xffffffff;
-			}
+				subSect = pageSect + i * SECTOR_NUM_PER_SUB_PAGE;
+				dmaStartSect = (subSect < startSect) ? startSect : subSect;
+				dmaEndSect = (subSect + SECTOR_NUM_PER_SUB_PAGE > endSect) ? endSect : subSect + SECTOR_NUM_PER_SUB_PAGE;
 
-			// copy valid pages from the victim block to the free block
-			if(i != PAGE_NUM_PER_BLOCK)
-			{
-				int j;
-				for(j=0 ; j<PAGE_NUM_PER_BLOCK ; j++)
+				if(dmaStartSect >= dmaEndSect)
+					continue;
+
+				if(dmaEndSect - dmaStartSect == SECTOR_NUM_PER_SUB_PAGE)
 				{
-					if(pageMap->pmEntry[dieNo][(victimBlock * PAGE_NUM_PER_BLOCK) + j].valid)
-					{
-						// page copy process
-						u32 validPage = victimBlock*PAGE_NUM_PER_BLOCK + j;
-						u32 freeBlock = dieBlock->dieEntry[dieNo].freeBlock;
-						u32 freePage = freeBlock*PAGE_NUM_PER_BLOCK + blockMap->bmEntry[dieNo][freeBlock].currentPage;
-
-						WaitWayFree(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM);
-						SsdRead(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM, validPage, GC_BUFFER_ADDR);
-						WaitWayFree(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM);
-						SsdProgram(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM, freePage, GC_BUFFER_ADDR);
-
-						// pageMap, blockMap update
-						u32 lpn = pageMap->pmEntry[dieNo][validPage].lpn;
-
-						pageMap->pmEntry[dieNo][lpn].ppn = freePage;
-						pageMap->pmEntry[dieNo][freePage].lpn = lpn;
-						blockMap->bmEntry[dieNo][freeBlock].currentPage++;
-					}
+					// whole sub-page lands in its packing buffer slot, the slot is released if it is all zero
+					u32 slotAddr = AllocPackSlot(dieNo, dieLpn + i);
+					DmaTransfer(hostCmd, &dmaCursor, slotAddr, SUB_PAGE_SIZE, DMA_HOST_TO_DEVICE);
+					if(IsDataFilled(slotAddr, SUB_PAGE_SIZE, 0))
+						WriteZeroSubPage(dieNo, dieLpn + i);
+				}
+				else
+				{
+					// merged with the rest of the sub-page read by PrePmRead
+					DmaTransfer(hostCmd, &dmaCursor, tempBuffer + (dmaStartSect - pageSect)*SECTOR_SIZE,
+								(dmaEndSect - dmaStartSect) * SECTOR_SIZE, DMA_HOST_TO_DEVICE);
+					PackSubPage(dieNo, dieLpn + i, tempBuffer + i * SUB_PAGE_SIZE);
 				}
 			}
-
-			// erased victim block becomes the free block for GC migration
-			EraseBlock(dieNo, victimBlock);
-			blockMap->bmEntry[dieNo][victimBlock].free = 0;
-
-			u32 currentBlock = dieBlock->dieEntry[dieNo].freeBlock;
-			dieBlock->dieEntry[dieNo].freeBlock = victimBlock;
-
-			return currentBlock;	// atomic GC completion
 		}
+
+		lpn++;
+		tempBuffer += PAGE_SIZE;
+		loop -= SECTOR_NUM_PER_PAGE;
 	}
 
-	// no free space anymore
-	assert(!"[WARNING] There are no free blocks. Abort terminate this ssd. [WARNING]");
-	return 1;
+	return 0;
 }
 
-void FlushPageBuf(u32 lpn, u32 bufAddr)
+// takes the least worn free block of the die, 0xffffffff for none
+u32 AllocFreeBlock(u32 dieNo)
 {
-	if (lpn == 0xffffffff)
-		return;
+	blockMap = (struct bmArray*)(BLOCK_MAP_ADDR);
+	dieBlock = (struct dieArray*)(DIE_MAP_ADDR);
+	gcSched = (struct gcSchedArray*)(GC_SCHED_ADDR);
 
-	u32 dieNo = lpn % DIE_NUM;
-	u32 dieLpn = lpn / DIE_NUM;
-	u32 ppn = pageMap->pmEntry[dieNo][dieLpn].ppn;
-	u32 dieBuffer;
+	u32 blockNo = dieBlock->dieEntry[dieNo].freeListHead;
 
-	if (ppn == 0xffffffff)
-	{
-		u32 freePageNo = FindFreePage(dieNo);
+	if(blockNo == BLOCK_NONE)
+		return 0xffffffff;
 
-//		xil_printf("free page: %6d(%d, %d, %4d)\r\n", freePageNo, dieNo%CHANNEL_NUM, dieNo/CHANNEL_NUM, freePageNo/PAGE_NUM_PER_BLOCK);
+	dieBlock->dieEntry[dieNo].freeListHead = blockMap->bmEntry[dieNo][blockNo].nextBlock;
+	if(dieBlock->dieEntry[dieNo].freeListHead != BLOCK_NONE)
+		blockMap->bmEntry[dieNo][dieBlock->dieEntry[dieNo].freeListHead].prevBlock = BLOCK_NONE;
+	else
+		dieBlock->dieEntry[dieNo].freeListTail = BLOCK_NONE;
 
-		WaitWayFree(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM);
-		dieBuffer = DIE_BUFFER_ADDR + dieNo*PAGE_SIZE;
-		memcpy((u32*)dieBuffer,(u32*)bufAddr,PAGE_SIZE);
-		SsdProgram(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM, freePageNo, dieBuffer);
-		//WaitWayFree(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM);
+	blockMap->bmEntry[dieNo][blockNo].free = 0;
+	blockMap->bmEntry[dieNo][blockNo].prevBlock = BLOCK_NONE;
+	blockMap->bmEntry[dieNo][blockNo].nextBlock = BLOCK_NONE;
+	gcSched->freeBlockCnt[dieNo]--;
+	SmartAllocBlock();
 
-		// pageMap update
-		pageMap->pmEntry[dieNo][dieLpn].ppn = freePageNo;
-		pageMap->pmEntry[dieNo][freePageNo].lpn = dieLpn;
-	}
+	return blockNo;
 }
 
-void UpdateMetaForOverwrite(u32 lpn)
+// an erased block is usually the most worn one, so the position is searched from the tail
+void PutFreeBlock(u32 dieNo, u32 blockNo)
 {
-	pageMap = (struct pmArray*)(PAGE_MAP_ADDR);
 	blockMap = (struct bmArray*)(BLOCK_MAP_ADDR);
-	gcMap = (struct gcArray*)(GC_MAP_ADDR);
+	dieBlock = (struct dieArray*)(DIE_MAP_ADDR);
+	gcSched = (struct gcSchedArray*)(GC_SCHED_ADDR);
 
-	u32 dieNo = lpn % DIE_NUM;
-	u32 dieLpn = lpn / DIE_NUM;
+	u32 eraseCnt = blockMap->bmEntry[dieNo][blockNo].eraseCnt;
+	u32 prev = dieBlock->dieEntry[dieNo].freeListTail;
 
-	if(pageMap->pmEntry[dieNo][dieLpn].ppn != 0xffffffff)
+	while((prev != BLOCK_NONE) && (blockMap->bmEntry[dieNo][prev].eraseCnt > eraseCnt))
+		prev = blockMap->bmEntry[dieNo][prev].prevBlock;
+
+	blockMap->bmEntry[dieNo][blockNo].free = 1;
+	blockMap->bmEntry[dieNo][blockNo].prevBlock = prev;
+	if(prev != BLOCK_NONE)
 	{
-		// GC victim block list management
-		u32 diePbn = pageMap->pmEntry[dieNo][dieLpn].ppn / PAGE_NUM_PER_BLOCK;
+		blockMap->bmEntry[dieNo][blockNo].nextBlock = blockMap->bmEntry[dieNo][prev].nextBlock;
+		blockMap->bmEntry[dieNo][prev].nextBlock = blockNo;
+	}
+	else
+	{
+		blockMap->bmEntry[dieNo][blockNo].nextBlock = dieBlock->dieEntry[dieNo].freeListHead;
+		dieBlock->dieEntry[dieNo].freeListHead = blockNo;
+	}
 
-		// unlink
-		if((blockMap->bmEntry[dieNo][diePbn].nextBlock != 0xffffffff) && (blockMap->bmEntry[dieNo][diePbn].prevBlock != 0xffffffff))
-		{
-			blockMap->bmEntry[dieNo][blockMap->bmEntry[dieNo][diePbn].prevBlock].nextBlock = blockMap->bmEntry[dieNo][diePbn].nextBlock;
-			blockMap->bmEntry[dieNo][blockMap->bmEntry[dieNo][diePbn].nextBlock].prevBlock = blockMap->bmEntry[dieNo][diePbn].prevBlock;
-		}
-		else if((blockMap->bmEntry[dieNo][diePbn].nextBlock == 0xffffffff) && (blockMap->bmEntry[dieNo][diePbn].prevBlock != 0xffffffff))
-		{
-			blockMap->bmEntry[dieNo][blockMap->bmEntry[dieNo][diePbn].prevBlock].nextBlock = 0xffffffff;
-			gcMap->gcEntry[dieNo][blockMap->bmEntry[dieNo][diePbn].invalidPageCnt].tail = blockMap->bmEntry[dieNo][diePbn].prevBlock;
-		}
-		else if((blockMap->bmEntry[dieNo][diePbn].nextBlock != 0xffffffff) && (blockMap->bmEntry[dieNo][diePbn].prevBlock == 0xffffffff))
-		{
-			blockMap->bmEntry[dieNo][blockMap->bmEntry[dieNo][diePbn].nextBlock].prevBlock = 0xffffffff;
-			gcMap->gcEntry[dieNo][blockMap->bmEntry[dieNo][diePbn].invalidPageCnt].head = blockMap->bmEntry[dieNo][diePbn].nextBlock;
-		}
-		else
-		{
-			gcMap->gcEntry[dieNo][blockMap->bmEntry[dieNo][diePbn].invalidPageCnt].head = 0xffffffff;
-			gcMap->gcEntry[dieNo][blockMap->bmEntry[dieNo][diePbn].invalidPageCnt].tail = 0xffffffff;
-		}
+	if(blockMap->bmEntry[dieNo][blockNo].nextBlock != BLOCK_NONE)
+		blockMap->bmEntry[dieNo][blockMap->bmEntry[dieNo][blockNo].nextBlock].prevBlock = blockNo;
+	else
+		dieBlock->dieEntry[dieNo].freeListTail = blockNo;
 
-//		xil_printf("[unlink] dieNo = %d, invalidPageCnt= %d, diePbn= %d, blockMap.prevBlock= %d, blockMap.nextBlock= %d, gcMap.head= %d, gcMap.tail= %d\r\n", dieNo, blockMap->bmEntry[dieNo][diePbn].invalidPageCnt, diePbn, blockMap->bmEntry[dieNo][diePbn].prevBlock, blockMap->bmEntry[dieNo][diePbn].nextBlock, gcMap->gcEntry[dieNo][blockMap->bmEntry[dieNo][diePbn].invalidPageCnt].head, gcMap->gcEntry[dieNo][blockMap->bmEntry[dieNo][diePbn].invalidPageCnt].tail);
+	gcSched->freeBlockCnt[dieNo]++;
+}
 
-		// invalidation update
-		pageMap->pmEntry[dieNo][pageMap->pmEntry[dieNo][dieLpn].ppn].valid = 0;
-		blockMap->bmEntry[dieNo][diePbn].invalidPageCnt++;
+void EraseBlock(u32 dieNo, u32 blockNo)
+{
+	pageMap = (struct pmArray*)(PAGE_MAP_ADDR);
+	blockMap = (struct bmArray*)(BLOCK_MAP_ADDR);
+	validMap = (struct vmArray*)(VALID_MAP_ADDR);
 
-		// insertion
-		if(gcMap->gcEntry[dieNo][blockMap->bmEntry[dieNo][diePbn].invalidPageCnt].tail != 0xffffffff)
+	// block map indicated blockNo initialization
+	blockMap->bmEntry[dieNo][blockNo].eraseCnt++;
+	SmartErase(dieNo, blockNo);
+	blockMap->bmEntry[dieNo][blockNo].invalidPageCnt = 0;
+	blockMap->bmEntry[dieNo][blockNo].currentPage = 0x0;
+	blockMap->bmEntry[dieNo][blockNo].prevBlock = BLOCK_NONE;
+	blockMap->bmEntry[dieNo][blockNo].nextBlock = BLOCK_NONE;
+
+#if MAP_CACHE_ENABLE
+	if(pageMap->cacheBlock[dieNo] == blockNo)
+		pageMap->cacheBlock[dieNo] = 0xffffffff;
+#else
+	memset(&pageMap->lpn[dieNo][blockNo * SUB_PAGE_NUM_PER_BLOCK], 0xff, sizeof(u32) * SUB_PAGE_NUM_PER_BLOCK);
+#endif
+	memset(validMap->vmEntry[dieNo][blockNo], 0, sizeof(u32) * VALID_WORD_NUM_PER_BLOCK);
+
+	WaitWayFree(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM);
+	IoErase(dieNo, IO_CLASS_GC, blockNo);
+
+	PutFreeBlock(dieNo, blockNo);
+	SmartFreeBlock();
+}
+
+// a victim under background GC is finished first, then victims are migrated as a whole
+void GarbageCollection(u32 dieNo)
+{
+//	xil_printf("GC occurs!\r\n");
+
+	gcSched = (struct gcSchedArray*)(GC_SCHED_ADDR);
+
+	// victim should have at least a page of invalid sub-pages
+	if((gcSched->victim[dieNo] == BLOCK_NONE) && !StartGcVictim(dieNo, SUB_PAGE_NUM_PER_PAGE))
+	{
+		// no free space anymore
+		assert(!"[WARNING] There are no free blocks. Abort terminate this ssd. [WARNING]");
+		return;
+	}
+
+	while(!GcStep(dieNo, PAGE_NUM_PER_BLOCK));
+}
+
+void InitGcSched()
+{
+	gcSched = (struct gcSchedArray*)(GC_SCHED_ADDR);
+	dieBlock = (struct dieArray*)(DIE_MAP_ADDR);
+	blockMap = (struct bmArray*)(BLOCK_MAP_ADDR);
+
+	u32 dieNo, blockNo;
+	for(dieNo=0 ; dieNo<DIE_NUM ; dieNo++)
+	{
+		gcSched->victim[dieNo] = BLOCK_NONE;
+		gcSched->nextPage[dieNo] = 0;
+		gcSched->debt[dieNo] = 0;
+
+		gcSched->freeBlockCnt[dieNo] = 0;
+		for(blockNo=dieBlock->dieEntry[dieNo].freeListHead ; blockNo!=BLOCK_NONE ; blockNo=blockMap->bmEntry[dieNo][blockNo].nextBlock)
+			gcSched->freeBlockCnt[dieNo]++;
+	}
+	gcSched->bgFreeBlockNum = GC_BG_FREE_BLOCK_NUM + OP_BLOCK_NUM / GC_BG_OP_DIV;
+	gcSched->idleDie = 0;
+	gcSched->lastDie = 0;
+
+	xil_printf("[ ssd background gc initialized. ]\r\n");
+}
+
+// takes the head of the fullest victim list if it has at least minInvalid invalid sub-pages
+int StartGcVictim(u32 dieNo, u32 minInvalid)
+{
+	blockMap = (struct bmArray*)(BLOCK_MAP_ADDR);
+	gcMap = (struct gcArray*)(GC_MAP_ADDR);
+	gcSched = (struct gcSchedArray*)(GC_SCHED_ADDR);
+
+	u32 i = FindVictimList(dieNo);
+	if((i == 0xffffffff) || (i < minInvalid))
+		return 0;
+
+	u32 victimBlock = gcMap->gcEntry[dieNo][i].head;	// GC victim block
+
+	// link setting
+	if(blockMap->bmEntry[dieNo][victimBlock].nextBlock != BLOCK_NONE)
+	{
+		gcMap->gcEntry[dieNo][i].head = blockMap->bmEntry[dieNo][victimBlock].nextBlock;
+		blockMap->bmEntry[dieNo][blockMap->bmEntry[dieNo][victimBlock].nextBlock].prevBlock = BLOCK_NONE;
+	}
+	else
+	{
+		gcMap->gcEntry[dieNo][i].head = BLOCK_NONE;
+		gcMap->gcEntry[dieNo][i].tail = BLOCK_NONE;
+		ClearGcBitmap(dieNo, i);
+	}
+	blockMap->bmEntry[dieNo][victimBlock].prevBlock = BLOCK_NONE;
+	blockMap->bmEntry[dieNo][victimBlock].nextBlock = BLOCK_NONE;
+	blockMap->bmEntry[dieNo][victimBlock].open = 1;
+
+	gcSched->victim[dieNo] = victimBlock;
+	gcSched->nextPage[dieNo] = 0;
+
+	return 1;
+}
+
+// copies at least pageNum valid pages of the victim to the open block of GC stream, the step ends with an empty GC packing buffer
+// migrated sub-pages are invalidated in the victim so that nothing finds their data there until it is erased
+// returns 1 when the victim is erased
+int GcStep(u32 dieNo, u32 pageNum)
+{
+	pageMap = (struct pmArray*)(PAGE_MAP_ADDR);
+	blockMap = (struct bmArray*)(BLOCK_MAP_ADDR);
+	dieBlock = (struct dieArray*)(DIE_MAP_ADDR);
+	validMap = (struct vmArray*)(VALID_MAP_ADDR);
+	gcSched = (struct gcSchedArray*)(GC_SCHED_ADDR);
+
+	u32 victimBlock = gcSched->victim[dieNo];
+	u32 gcPackLpn[SUB_PAGE_NUM_PER_PAGE];
+	u32 pageLpn[SUB_PAGE_NUM_PER_PAGE];
+	u32 validBits, pageBits, pageMask;
+	int j, k, w, shift, gcSlotCnt;
+
+	// GC buffers are shared by all dies, the last step may still be programming from them
+	WaitWayFree(gcSched->lastDie % CHANNEL_NUM, gcSched->lastDie / CHANNEL_NUM);
+	gcSched->lastDie = dieNo;
+
+	for(k=0 ; k<SUB_PAGE_NUM_PER_PAGE ; k++)
+		gcPackLpn[k] = 0xffffffff;
+	gcSlotCnt = 0;
+	pageMask = (1 << SUB_PAGE_NUM_PER_PAGE) - 1;
+
+	// valid bits are scanned word by word from the next page, skipping to the next valid sub-page
+	while((gcSched->nextPage[dieNo] < PAGE_NUM_PER_BLOCK) && (pageNum || gcSlotCnt))
+	{
+		j = gcSched->nextPage[dieNo];
+		w = j * SUB_PAGE_NUM_PER_PAGE / 32;
+		validBits = validMap->vmEntry[dieNo][victimBlock][w] & (0xffffffff << (j * SUB_PAGE_NUM_PER_PAGE % 32));
+
+		if(validBits == 0)
 		{
-			blockMap->bmEntry[dieNo][diePbn].prevBlock = gcMap->gcEntry[dieNo][blockMap->bmEntry[dieNo][diePbn].invalidPageCnt].tail;
-			blockMap->bmEntry[dieNo][diePbn].nextBlock = 0xffffffff;
-			blockMap->bmEntry[dieNo][gcMap->gcEntry[dieNo][blockMap->bmEntry[dieNo][diePbn].invalidPageCnt].tail].nextBlock = diePbn;
-			gcMap->gcEntry[dieNo][blockMap->bmEntry[dieNo][diePbn].invalidPageCnt].tail = diePbn;
+			gcSched->nextPage[dieNo] = (w + 1) * 32 / SUB_PAGE_NUM_PER_PAGE;
+			continue;
+		}
+
+		shift = __builtin_ctz(validBits) / SUB_PAGE_NUM_PER_PAGE * SUB_PAGE_NUM_PER_PAGE;
+		pageBits = (validBits >> shift) & pageMask;
+
+		j = (w*32 + shift) / SUB_PAGE_NUM_PER_PAGE;
+		gcSched->nextPage[dieNo] = j + 1;
+		u32 validPage = victimBlock*PAGE_NUM_PER_BLOCK + j;
+
+		WaitWayFree(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM);
+		IoRead(dieNo, IO_CLASS_GC, validPage, GC_BUFFER_ADDR);
+		WaitWayFree(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM);
+
+		if(pageBits == pageMask)
+		{
+			// page copy process
+			for(k=0 ; k<SUB_PAGE_NUM_PER_PAGE ; k++)
+				pageLpn[k] = GetP2L(dieNo, validPage*SUB_PAGE_NUM_PER_PAGE + k);
+			u32 freePage = FindFreePage(dieNo, STREAM_GC);
+
+			// pageMap, blockMap update, a container page drops its overwritten slots before it is copied
+			if(pageLpn[0] == CONTAINER_4BYTE)
+				MoveContainer(dieNo, validPage, freePage, GC_BUFFER_ADDR);
+			else
+				UpdateMetaForProgram(dieNo, freePage, pageLpn);
+
+			WaitWayFree(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM);	// page map page of the GC block may be in program
+			IoProgram(dieNo, IO_CLASS_GC, freePage, GC_BUFFER_ADDR);
+			SmartGcProgram();
 		}
 		else
 		{
-			blockMap->bmEntry[dieNo][diePbn].prevBlock = 0xffffffff;
-			blockMap->bmEntry[dieNo][diePbn].nextBlock = 0xffffffff;
-			gcMap->gcEntry[dieNo][blockMap->bmEntry[dieNo][diePbn].invalidPageCnt].head = diePbn;
-			gcMap->gcEntry[dieNo][blockMap->bmEntry[dieNo][diePbn].invalidPageCnt].tail = diePbn;
+			// valid sub-pages of partially invalid pages are packed together
+			for(k=0 ; k<SUB_PAGE_NUM_PER_PAGE ; k++)
+				if(pageBits & (1 << k))
+				{
+					if(gcSlotCnt == SUB_PAGE_NUM_PER_PAGE)
+					{
+						FlushGcPackBuf(dieNo, gcPackLpn);
+						gcSlotCnt = 0;
+					}
+
+					CopyData(GC_PACK_BUFFER_ADDR + gcSlotCnt*SUB_PAGE_SIZE, GC_BUFFER_ADDR + k*SUB_PAGE_SIZE, SUB_PAGE_SIZE);
+					gcPackLpn[gcSlotCnt++] = GetP2L(dieNo, validPage*SUB_PAGE_NUM_PER_PAGE + k);
+				}
+
+			if(gcSlotCnt == SUB_PAGE_NUM_PER_PAGE)
+			{
+				FlushGcPackBuf(dieNo, gcPackLpn);
+				gcSlotCnt = 0;
+			}
+		}
+
+		for(k=0 ; k<SUB_PAGE_NUM_PER_PAGE ; k++)
+			if(pageBits & (1 << k))
+				InvalidateSubPage(dieNo, validPage*SUB_PAGE_NUM_PER_PAGE + k);
+
+		if(pageNum)
+			pageNum--;
+	}
+
+	if(gcSlotCnt)
+		FlushGcPackBuf(dieNo, gcPackLpn);
+
+	if(gcSched->nextPage[dieNo] < PAGE_NUM_PER_BLOCK)
+		return 0;
+
+	// erased victim block joins the free list, the reserved block is refilled if GC stream has taken it
+	blockMap->bmEntry[dieNo][victimBlock].open = 0;
+	gcSched->victim[dieNo] = BLOCK_NONE;
+	EraseBlock(dieNo, victimBlock);
+
+	if(dieBlock->dieEntry[dieNo].freeBlock == 0xffffffff)
+		dieBlock->dieEntry[dieNo].freeBlock = AllocFreeBlock(dieNo);
+
+	return 1;
+}
+
+// a die running short of free blocks migrates a victim in steps
+// a step needs a free block or the reserved one, the victim left holds few valid pages to fit in the block it takes
+int GcNeeded(u32 dieNo)
+{
+	dieBlock = (struct dieArray*)(DIE_MAP_ADDR);
+	gcSched = (struct gcSchedArray*)(GC_SCHED_ADDR);
+
+	if(gcSched->freeBlockCnt[dieNo] >= gcSched->bgFreeBlockNum)
+		return 0;
+
+	return (gcSched->freeBlockCnt[dieNo] != 0) || (dieBlock->dieEntry[dieNo].freeBlock != 0xffffffff);
+}
+
+// host programs of a die pay for migration of a victim by GC debt, so that write latency stays flat instead of
+// stalling on a whole victim when the die runs out of free blocks
+// debt grows by the pages left in the victim over the pages host can write until the free blocks are gone
+void GcWriteStep(u32 dieNo)
+{
+#if GC_BG_FREE_BLOCK_NUM
+	gcSched = (struct gcSchedArray*)(GC_SCHED_ADDR);
+
+	if(!GcNeeded(dieNo))
+	{
+		gcSched->debt[dieNo] = 0;
+		return;
+	}
+
+	// a die close to running out takes any victim GC would take, it will be needed anyway
+	if(gcSched->victim[dieNo] == BLOCK_NONE)
+	{
+		u32 minInvalid = (gcSched->freeBlockCnt[dieNo] <= GC_PACE_FREE_BLOCK_NUM) ? SUB_PAGE_NUM_PER_PAGE : GC_BG_MIN_INVALID;
+		if(!StartGcVictim(dieNo, minInvalid))
+			return;
+	}
+
+	// GC stream takes free pages as well as host
+	u32 validPage = (CountValid(dieNo, gcSched->victim[dieNo]) + SUB_PAGE_NUM_PER_PAGE - 1) / SUB_PAGE_NUM_PER_PAGE;
+	u32 freePage = gcSched->freeBlockCnt[dieNo] * PAGE_NUM_PER_BLOCK;
+
+	if(freePage <= validPage)
+	{
+		// free pages cannot hold what is left in the victim, it is finished at once as unthrottled GC would do
+		gcSched->debt[dieNo] = 0;
+		GcStep(dieNo, PAGE_NUM_PER_BLOCK);
+		return;
+	}
+
+	gcSched->debt[dieNo] += validPage * GC_DEBT_UNIT / (freePage - validPage) + 1;
+
+	u32 pageNum = gcSched->debt[dieNo] / GC_DEBT_UNIT;
+	if(pageNum)
+	{
+		gcSched->debt[dieNo] -= pageNum * GC_DEBT_UNIT;
+		GcStep(dieNo, pageNum);
+	}
+#endif
+}
+
+// a step of the first die from idleDie running short of free blocks, called while no request waits
+void GcIdle()
+{
+#if GC_BG_FREE_BLOCK_NUM
+	gcSched = (struct gcSchedArray*)(GC_SCHED_ADDR);
+
+	u32 i, dieNo;
+	for(i=0 ; i<DIE_NUM ; i++)
+	{
+		dieNo = (gcSched->idleDie + i) % DIE_NUM;
+
+		if(!GcNeeded(dieNo))
+			continue;
+
+		if((gcSched->victim[dieNo] == BLOCK_NONE) && !StartGcVictim(dieNo, GC_BG_MIN_INVALID))
+			continue;
+
+		// dies take turns so that a busy die does not hold back the others
+		gcSched->idleDie = (dieNo + 1) % DIE_NUM;
+		GcStep(dieNo, GC_IDLE_STEP_PAGE_NUM);
+		return;
+	}
+#endif
+}
+
+// victims under background GC go back to their victim lists before meta data is saved
+void ReleaseGcVictim()
+{
+	blockMap = (struct bmArray*)(BLOCK_MAP_ADDR);
+	gcSched = (struct gcSchedArray*)(GC_SCHED_ADDR);
+
+	u32 dieNo, victimBlock;
+	for(dieNo=0 ; dieNo<DIE_NUM ; dieNo++)
+	{
+		victimBlock = gcSched->victim[dieNo];
+		if(victimBlock == BLOCK_NONE)
+			continue;
+
+		blockMap->bmEntry[dieNo][victimBlock].open = 0;
+		InsertGcList(dieNo, victimBlock);
+		gcSched->victim[dieNo] = BLOCK_NONE;
+	}
+}
+
+void FlushGcPackBuf(u32 dieNo, u32* lpn)
+{
+	u32 freePage = FindFreePage(dieNo, STREAM_GC);
+
+	WaitWayFree(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM);
+	IoProgram(dieNo, IO_CLASS_GC, freePage, GC_PACK_BUFFER_ADDR);
+	SmartGcProgram();
+
+	UpdateMetaForProgram(dieNo, freePage, lpn);
+
+	int i;
+	for(i=0 ; i<SUB_PAGE_NUM_PER_PAGE ; i++)
+		lpn[i] = 0xffffffff;
+}
+
+int FindPackSlot(u32 dieNo, u32 stream, u32 dieLpn)
+{
+	packBuf = (struct pbArray*)(PACK_MAP_ADDR);
+
+	int i;
+	for(i=0 ; i<SUB_PAGE_NUM_PER_PAGE ; i++)
+		if(packBuf->pbEntry[dieNo][stream].lpn[i] == dieLpn)
+			return i;
+
+	assert(!"[WARNING] Packing buffer slot is not found. [WARNING]");
+	return 0;
+}
+
+// stream whose packing buffer holds a buffered logical sub-page
+u32 FindPackStream(u32 dieNo, u32 dieLpn)
+{
+	packBuf = (struct pbArray*)(PACK_MAP_ADDR);
+
+	int i, j;
+	for(j=0 ; j<STREAM_HOST_NUM ; j++)
+		for(i=0 ; i<SUB_PAGE_NUM_PER_PAGE ; i++)
+			if(packBuf->pbEntry[dieNo][j].lpn[i] == dieLpn)
+				return j;
+
+	assert(!"[WARNING] Packing buffer slot is not found. [WARNING]");
+	return 0;
+}
+
+void ReadSubPage(u32 dieNo, u32 dieLpn, u32 bufAddr)
+{
+	pageMap = (struct pmArray*)(PAGE_MAP_ADDR);
+
+	u32 ppn = GetL2P(dieNo, dieLpn);
+	u32 subPageBuffer;
+
+	// shared sub-page is read through its dedup entry, which is also the key of its packing slot
+	if(IS_DEDUP_ID(ppn))
+	{
+		dieLpn = ppn;
+		ppn = GetL2P(dieNo, dieLpn);
+	}
+
+	if(ppn == BUFFERED_4BYTE)
+	{
+		u32 stream = FindPackStream(dieNo, dieLpn);
+		CopyData(bufAddr, packBuf->pbEntry[dieNo][stream].bufAddr + FindPackSlot(dieNo, stream, dieLpn)*SUB_PAGE_SIZE, SUB_PAGE_SIZE);
+	}
+	else if(IS_COMP(ppn))
+		ReadCompSub(dieNo, ppn, bufAddr);
+	else if(ppn < ZERO_4BYTE)
+	{
+//		xil_printf("ReadSubPage pdie, ppn = %d, %d\r\n", dieNo, ppn);
+
+		if(SUB_PAGE_NUM_PER_PAGE == 1)
+		{
+			if(!IoRead(dieNo, IO_CLASS_HOST_READ, ppn, bufAddr))
+				WaitWayFree(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM);
+		}
+		else
+		{
+			subPageBuffer = SUB_PAGE_BUFFER_ADDR + dieNo*PAGE_SIZE;
+			if(!IoRead(dieNo, IO_CLASS_HOST_READ, ppn / SUB_PAGE_NUM_PER_PAGE, subPageBuffer))
+				WaitWayFree(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM);
+			CopyData(bufAddr, subPageBuffer + (ppn % SUB_PAGE_NUM_PER_PAGE)*SUB_PAGE_SIZE, SUB_PAGE_SIZE);
+		}
+	}
+	else
+		CopyData(bufAddr, ZERO_BUFFER_ADDR, SUB_PAGE_SIZE);	// unmapped or zero-mapped
+}
+
+u32 AllocWriteBuf()
+{
+	writeBuf = (struct wbArray*)(WRITE_MAP_ADDR);
+
+	int i;
+	if(writeBuf->freeCnt == 0)
+	{
+		// buffers of completed programs are returned to the pool
+		for(i=0 ; i<DIE_NUM ; i++)
+			if((writeBuf->progBuf[i] != 0xffffffff) && (SsdReadChWayStatus(i % CHANNEL_NUM, i / CHANNEL_NUM) == 0))
+				ReleaseWriteBuf(i);
+
+		// otherwise a queued program is issued or a program in progress is waited for
+		while(writeBuf->freeCnt == 0)
+		{
+			i = writeBuf->reclaimDie;
+			writeBuf->reclaimDie = (i + 1) % DIE_NUM;
+
+			IoReclaimWriteBuf(i);
+		}
+	}
+
+	return writeBuf->freeBuf[--writeBuf->freeCnt];
+}
+
+void ReleaseWriteBuf(u32 dieNo)
+{
+	writeBuf = (struct wbArray*)(WRITE_MAP_ADDR);
+
+	writeBuf->freeBuf[writeBuf->freeCnt++] = writeBuf->progBuf[dieNo];
+	writeBuf->progBuf[dieNo] = 0xffffffff;
+}
+
+// buffer not handed to a program returns to the pool
+void FreeWriteBuf(u32 bufAddr)
+{
+	writeBuf = (struct wbArray*)(WRITE_MAP_ADDR);
+
+	writeBuf->freeBuf[writeBuf->freeCnt++] = bufAddr;
+}
+
+// the program is queued if the die is busy, the buffer returns to the pool after the program
+void ProgramWriteBuf(u32 dieNo, u32 ppn, u32 bufAddr)
+{
+	IoQueueProgram(dieNo, ppn, bufAddr);
+}
+
+u32 AllocPackSlot(u32 dieNo, u32 dieLpn)
+{
+	packBuf = (struct pbArray*)(PACK_MAP_ADDR);
+
+	int slot;
+	u32 stream;
+
+	if(GetL2P(dieNo, dieLpn) == BUFFERED_4BYTE)
+	{
+		// overwrite in the packing buffer
+		stream = FindPackStream(dieNo, dieLpn);
+		slot = FindPackSlot(dieNo, stream, dieLpn);
+	}
+	else
+	{
+		stream = ClassifyStream(dieNo, dieLpn);
+		UpdateMetaForOverwrite(dieNo, dieLpn);
+
+		if(packBuf->pbEntry[dieNo][stream].slotCnt == SUB_PAGE_NUM_PER_PAGE)
+			FlushPackBuf(dieNo, stream);
+
+		if(packBuf->pbEntry[dieNo][stream].bufAddr == 0xffffffff)
+			packBuf->pbEntry[dieNo][stream].bufAddr = AllocWriteBuf();
+
+		slot = FindPackSlot(dieNo, stream, 0xffffffff);
+		packBuf->pbEntry[dieNo][stream].lpn[slot] = dieLpn;
+		packBuf->pbEntry[dieNo][stream].slotCnt++;
+
+		SetL2P(dieNo, dieLpn, BUFFERED_4BYTE);
+	}
+
+	return packBuf->pbEntry[dieNo][stream].bufAddr + slot*SUB_PAGE_SIZE;
+}
+
+void PackSubPage(u32 dieNo, u32 dieLpn, u32 bufAddr)
+{
+	if(IsDataFilled(bufAddr, SUB_PAGE_SIZE, 0))
+		WriteZeroSubPage(dieNo, dieLpn);
+	else
+		CopyData(AllocPackSlot(dieNo, dieLpn), bufAddr, SUB_PAGE_SIZE);
+}
+
+// previous data is invalidated and the sub-page reads as zero without a program
+void WriteZeroSubPage(u32 dieNo, u32 dieLpn)
+{
+	UpdateMetaForOverwrite(dieNo, dieLpn);
+	SetL2P(dieNo, dieLpn, ZERO_4BYTE);
+}
+
+void FlushPackBuf(u32 dieNo, u32 stream)
+{
+	packBuf = (struct pbArray*)(PACK_MAP_ADDR);
+
+	if(packBuf->pbEntry[dieNo][stream].slotCnt == 0)
+		return;
+
+	u32 freePageNo = FindFreePage(dieNo, stream);
+
+//	xil_printf("free page: %6d(%d, %d, %4d)\r\n", freePageNo, dieNo%CHANNEL_NUM, dieNo/CHANNEL_NUM, freePageNo/PAGE_NUM_PER_BLOCK);
+
+	// the buffer is handed to the program, a new one is taken at the next packing
+	ProgramWriteBuf(dieNo, freePageNo, packBuf->pbEntry[dieNo][stream].bufAddr);
+	packBuf->pbEntry[dieNo][stream].bufAddr = 0xffffffff;
+
+	UpdateMetaForProgram(dieNo, freePageNo, packBuf->pbEntry[dieNo][stream].lpn);
+
+	int i;
+	for(i=0 ; i<SUB_PAGE_NUM_PER_PAGE ; i++)
+		packBuf->pbEntry[dieNo][stream].lpn[i] = 0xffffffff;
+	packBuf->pbEntry[dieNo][stream].slotCnt = 0;
+}
+
+void FlushAllPackBuf()
+{
+	int i, j;
+	for(i=0 ; i<DIE_NUM ; i++)
+	{
+		for(j=0 ; j<STREAM_HOST_NUM ; j++)
+			FlushPackBuf(i, j);
+		FlushContainer(i);
+	}
+
+	IoDrain();
+	for(i=0 ; i<DIE_NUM ; i++)
+		WaitWayFree(i % CHANNEL_NUM, i / CHANNEL_NUM);
+}
+
+void UpdateMetaForProgram(u32 dieNo, u32 ppn, u32* lpn)
+{
+	pageMap = (struct pmArray*)(PAGE_MAP_ADDR);
+
+	u32 subPpn;
+	int i;
+	for(i=0 ; i<SUB_PAGE_NUM_PER_PAGE ; i++)
+	{
+		subPpn = ppn * SUB_PAGE_NUM_PER_PAGE + i;
+
+		if(lpn[i] != 0xffffffff)
+		{
+			SetL2P(dieNo, lpn[i], subPpn);
+			SetP2L(dieNo, subPpn, lpn[i]);
+			SetValid(dieNo, subPpn);
 		}
+		else
+			InvalidateSubPage(dieNo, subPpn);	// empty slot is invalid from the first
+	}
+}
+
+void UpdateMetaForOverwrite(u32 dieNo, u32 dieLpn)
+{
+	pageMap = (struct pmArray*)(PAGE_MAP_ADDR);
+	packBuf = (struct pbArray*)(PACK_MAP_ADDR);
+
+	u32 ppn = GetL2P(dieNo, dieLpn);
+
+	if(ppn == BUFFERED_4BYTE)
+	{
+		// release the slot of the packing buffer
+		u32 stream = FindPackStream(dieNo, dieLpn);
+		packBuf->pbEntry[dieNo][stream].lpn[FindPackSlot(dieNo, stream, dieLpn)] = 0xffffffff;
+		packBuf->pbEntry[dieNo][stream].slotCnt--;
+	}
+	else if(IS_DEDUP_ID(ppn))
+		ReleaseDedupRef(dieNo, ppn - DEDUP_ID_BASE);
+	else if(IS_COMP(ppn))
+		ReleaseCompSub(dieNo, ppn);
+	else if(ppn < ZERO_4BYTE)
+		InvalidateSubPage(dieNo, ppn);
+
+	if(ppn != 0xffffffff)
+		SetL2P(dieNo, dieLpn, 0xffffffff);
+}
+
+void InvalidateSubPage(u32 dieNo, u32 ppn)
+{
+	pageMap = (struct pmArray*)(PAGE_MAP_ADDR);
+	blockMap = (struct bmArray*)(BLOCK_MAP_ADDR);
+	gcMap = (struct gcArray*)(GC_MAP_ADDR);
+
+	// GC victim block list management
+	u32 diePbn = ppn / SUB_PAGE_NUM_PER_BLOCK;
+
+	// open blocks are linked when they are closed
+	if(blockMap->bmEntry[dieNo][diePbn].open)
+	{
+		ClearValid(dieNo, ppn);
+		blockMap->bmEntry[dieNo][diePbn].invalidPageCnt++;
+		return;
+	}
+
+	// unlink
+	if((blockMap->bmEntry[dieNo][diePbn].nextBlock != BLOCK_NONE) && (blockMap->bmEntry[dieNo][diePbn].prevBlock != BLOCK_NONE))
+	{
+		blockMap->bmEntry[dieNo][blockMap->bmEntry[dieNo][diePbn].prevBlock].nextBlock = blockMap->bmEntry[dieNo][diePbn].nextBlock;
+		blockMap->bmEntry[dieNo][blockMap->bmEntry[dieNo][diePbn].nextBlock].prevBlock = blockMap->bmEntry[dieNo][diePbn].prevBlock;
+	}
+	else if((blockMap->bmEntry[dieNo][diePbn].nextBlock == BLOCK_NONE) && (blockMap->bmEntry[dieNo][diePbn].prevBlock != BLOCK_NONE))
+	{
+		blockMap->bmEntry[dieNo][blockMap->bmEntry[dieNo][diePbn].prevBlock].nextBlock = BLOCK_NONE;
+		gcMap->gcEntry[dieNo][blockMap->bmEntry[dieNo][diePbn].invalidPageCnt].tail = blockMap->bmEntry[dieNo][diePbn].prevBlock;
+	}
+	else if((blockMap->bmEntry[dieNo][diePbn].nextBlock != BLOCK_NONE) && (blockMap->bmEntry[dieNo][diePbn].prevBlock == BLOCK_NONE))
+	{
+		blockMap->bmEntry[dieNo][blockMap->bmEntry[dieNo][diePbn].nextBlock].prevBlock = BLOCK_NONE;
+		gcMap->gcEntry[dieNo][blockMap->bmEntry[dieNo][diePbn].invalidPageCnt].head = blockMap->bmEntry[dieNo][diePbn].nextBlock;
+	}
+	else
+	{
+		gcMap->gcEntry[dieNo][blockMap->bmEntry[dieNo][diePbn].invalidPageCnt].head = BLOCK_NONE;
+		gcMap->gcEntry[dieNo][blockMap->bmEntry[dieNo][diePbn].invalidPageCnt].tail = BLOCK_NONE;
+		ClearGcBitmap(dieNo, blockMap->bmEntry[dieNo][diePbn].invalidPageCnt);
+	}
+
+//	xil_printf("[unlink] dieNo = %d, invalidPageCnt= %d, diePbn= %d, blockMap.prevBlock= %d, blockMap.nextBlock= %d, gcMap.head= %d, gcMap.tail= %d\r\n", dieNo, blockMap->bmEntry[dieNo][diePbn].invalidPageCnt, diePbn, blockMap->bmEntry[dieNo][diePbn].prevBlock, blockMap->bmEntry[dieNo][diePbn].nextBlock, gcMap->gcEntry[dieNo][blockMap->bmEntry[dieNo][diePbn].invalidPageCnt].head, gcMap->gcEntry[dieNo][blockMap->bmEntry[dieNo][diePbn].invalidPageCnt].tail);
+
+	// invalidation update
+	ClearValid(dieNo, ppn);
+	blockMap->bmEntry[dieNo][diePbn].invalidPageCnt++;
+
+	InsertGcList(dieNo, diePbn);
+}
+
+void InsertGcList(u32 dieNo, u32 diePbn)
+{
+	blockMap = (struct bmArray*)(BLOCK_MAP_ADDR);
+	gcMap = (struct gcArray*)(GC_MAP_ADDR);
+
+	// insertion
+	if(gcMap->gcEntry[dieNo][blockMap->bmEntry[dieNo][diePbn].invalidPageCnt].tail != BLOCK_NONE)
+	{
+		blockMap->bmEntry[dieNo][diePbn].prevBlock = gcMap->gcEntry[dieNo][blockMap->bmEntry[dieNo][diePbn].invalidPageCnt].tail;
+		blockMap->bmEntry[dieNo][diePbn].nextBlock = BLOCK_NONE;
+		blockMap->bmEntry[dieNo][gcMap->gcEntry[dieNo][blockMap->bmEntry[dieNo][diePbn].invalidPageCnt].tail].nextBlock = diePbn;
+		gcMap->gcEntry[dieNo][blockMap->bmEntry[dieNo][diePbn].invalidPageCnt].tail = diePbn;
+	}
+	else
+	{
+		blockMap->bmEntry[dieNo][diePbn].prevBlock = BLOCK_NONE;
+		blockMap->bmEntry[dieNo][diePbn].nextBlock = BLOCK_NONE;
+		gcMap->gcEntry[dieNo][blockMap->bmEntry[dieNo][diePbn].invalidPageCnt].head = diePbn;
+		gcMap->gcEntry[dieNo][blockMap->bmEntry[dieNo][diePbn].invalidPageCnt].tail = diePbn;
+		SetGcBitmap(dieNo, blockMap->bmEntry[dieNo][diePbn].invalidPageCnt);
 	}
 }
 
+void SetGcBitmap(u32 dieNo, u32 invalidPageCnt)
+{
+	gcMap = (struct gcArray*)(GC_MAP_ADDR);
+
+	gcMap->bitmap[dieNo][invalidPageCnt / 32] |= (1 << (invalidPageCnt % 32));
+	gcMap->summary[dieNo] |= (1 << (invalidPageCnt / 32));
+}
+
+void ClearGcBitmap(u32 dieNo, u32 invalidPageCnt)
+{
+	gcMap = (struct gcArray*)(GC_MAP_ADDR);
+
+	gcMap->bitmap[dieNo][invalidPageCnt / 32] &= ~(1 << (invalidPageCnt % 32));
+	if(gcMap->bitmap[dieNo][invalidPageCnt / 32] == 0)
+		gcMap->summary[dieNo] &= ~(1 << (invalidPageCnt / 32));
+}
+
+// invalid sub-page count of the fullest non-empty victim list, 0xffffffff for none
+u32 FindVictimList(u32 dieNo)
+{
+	gcMap = (struct gcArray*)(GC_MAP_ADDR);
+
+	if(gcMap->summary[dieNo] == 0)
+		return 0xffffffff;
+
+	u32 word = 31 - __builtin_clz(gcMap->summary[dieNo]);
+
+	return word * 32 + 31 - __builtin_clz(gcMap->bitmap[dieNo][word]);
+}
+
+void SetValid(u32 dieNo, u32 ppn)
+{
+	validMap = (struct vmArray*)(VALID_MAP_ADDR);
+
+	validMap->vmEntry[dieNo][ppn / SUB_PAGE_NUM_PER_BLOCK][(ppn % SUB_PAGE_NUM_PER_BLOCK) / 32] |= (1 << ((ppn % SUB_PAGE_NUM_PER_BLOCK) % 32));
+}
+
+void ClearValid(u32 dieNo, u32 ppn)
+{
+	validMap = (struct vmArray*)(VALID_MAP_ADDR);
+
+	validMap->vmEntry[dieNo][ppn / SUB_PAGE_NUM_PER_BLOCK][(ppn % SUB_PAGE_NUM_PER_BLOCK) / 32] &= ~(1 << ((ppn % SUB_PAGE_NUM_PER_BLOCK) % 32));
+}
+
+int IsValid(u32 dieNo, u32 ppn)
+{
+	validMap = (struct vmArray*)(VALID_MAP_ADDR);
+
+	return (validMap->vmEntry[dieNo][ppn / SUB_PAGE_NUM_PER_BLOCK][(ppn % SUB_PAGE_NUM_PER_BLOCK) / 32] >> ((ppn % SUB_PAGE_NUM_PER_BLOCK) % 32)) & 0x1;
+}
+
+int CountValid(u32 dieNo, u32 blockNo)
+{
+	validMap = (struct vmArray*)(VALID_MAP_ADDR);
+
+	return CountDataBits((u32)validMap->vmEntry[dieNo][blockNo], sizeof(u32) * VALID_WORD_NUM_PER_BLOCK);
+}
+
+// P2L entry of a physical sub-page, a closed block gives it from its page map page when the mapping table is cached
+u32 GetP2L(u32 dieNo, u32 ppn)
+{
+	pageMap = (struct pmArray*)(PAGE_MAP_ADDR);
+
+#if MAP_CACHE_ENABLE
+	dieBlock = (struct dieArray*)(DIE_MAP_ADDR);
+
+	u32 blockNo = ppn / SUB_PAGE_NUM_PER_BLOCK;
+	u32 stream, dieLpn;
+
+	for(stream=0 ; stream<STREAM_NUM ; stream++)
+		if(dieBlock->dieEntry[dieNo].currentBlock[stream] == blockNo)
+			return pageMap->lpn[dieNo][stream][ppn % SUB_PAGE_NUM_PER_BLOCK];
+
+	// page map page of a closed block is its last page, GC and wear leveling go through a block in order
+	if(pageMap->cacheBlock[dieNo] != blockNo)
+	{
+		WaitWayFree(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM);
+		IoRead(dieNo, IO_CLASS_META, blockNo * PAGE_NUM_PER_BLOCK + PAGE_NUM_PER_BLOCK - 1, P2L_CACHE_ADDR + dieNo*PAGE_SIZE);
+		WaitWayFree(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM);
+
+		pageMap->cacheBlock[dieNo] = blockNo;
+	}
+
+	dieLpn = *(u32*)(P2L_CACHE_ADDR + dieNo*PAGE_SIZE + (ppn % SUB_PAGE_NUM_PER_BLOCK) * sizeof(u32));
+
+#if DEDUP_ENABLE
+	// the page map page keeps the owner of a sub-page shared after the block is closed, the sub-page is found by its dedup entry
+	if((dieLpn < SUB_PAGE_NUM_PER_DIE) && (GetL2P(dieNo, dieLpn) != ppn))
+		return FindDedupId(dieNo, ppn);
+#endif
+
+	return dieLpn;
+#else
+	return pageMap->lpn[dieNo][ppn];
+#endif
+}
+
+void SetP2L(u32 dieNo, u32 ppn, u32 dieLpn)
+{
+	pageMap = (struct pmArray*)(PAGE_MAP_ADDR);
+
+#if MAP_CACHE_ENABLE
+	dieBlock = (struct dieArray*)(DIE_MAP_ADDR);
+
+	u32 blockNo = ppn / SUB_PAGE_NUM_PER_BLOCK;
+	u32 stream;
+
+	// page map page of a closed block is not rewritten
+	for(stream=0 ; stream<STREAM_NUM ; stream++)
+		if(dieBlock->dieEntry[dieNo].currentBlock[stream] == blockNo)
+			pageMap->lpn[dieNo][stream][ppn % SUB_PAGE_NUM_PER_BLOCK] = dieLpn;
+#else
+	pageMap->lpn[dieNo][ppn] = dieLpn;
+#endif
+}
+
 //void MvData(u32* src, u32* dst, u32 sectSize)
 //{
 //	int i;
@@ -700,75 +1671,65 @@ void UpdateMetaForOverwrite(u32 lpn)
 //		dst[i] = src[i];
 //}
 
-void PageMapFlushForCurrentBlock(u32 dieNo, u32 tempBuffer) //save page map of current block
+void PageMapFlushForCurrentBlock(u32 dieNo, u32 stream, u32 tempBuffer) //save page map of current block
 {
-	u32 pmAddrForCurrentBlock;
-	u32* shifter;
+	u32 pmAddrForCurrentBlock, blockNo;
 	u32* pmDataBuf;
-	int pageCount;
 
 	pageMap = (struct pmArray*)(PAGE_MAP_ADDR);
 	blockMap = (struct bmArray*)(BLOCK_MAP_ADDR);
 	dieBlock = (struct dieArray*)(DIE_MAP_ADDR);
 	ciMap = (struct ciArray*)(CI_ADDR);
+	seqMap = (struct seqArray*)(SEQ_MAP_ADDR);
 
-	if(blockMap->bmEntry[dieNo][dieBlock->dieEntry[dieNo].currentBlock].currentPage!=0xffff)
-	{
-		blockMap->bmEntry[dieNo][dieBlock->dieEntry[dieNo].currentBlock].currentPage++;
-		pageMap->pmEntry[dieNo][(dieBlock->dieEntry[dieNo].currentBlock * PAGE_NUM_PER_BLOCK) + blockMap->bmEntry[dieNo][dieBlock->dieEntry[dieNo].currentBlock].currentPage].valid = 0;
-		pmAddrForCurrentBlock = PAGE_MAP_ADDR + 2*sizeof(u32)*(dieNo*PAGE_NUM_PER_DIE + (dieBlock->dieEntry[dieNo].currentBlock)*PAGE_NUM_PER_BLOCK);
+	blockNo = dieBlock->dieEntry[dieNo].currentBlock[stream];
 
-		for(pageCount=0; pageCount<blockMap->bmEntry[dieNo][dieBlock->dieEntry[dieNo].currentBlock].currentPage; pageCount++)
-		{
-			shifter = (u32*)(pmAddrForCurrentBlock + 2*sizeof(u32)*pageCount+sizeof(u32)); // to remove ppn
-			pmDataBuf = (u32*)(tempBuffer + pageCount*sizeof(u32));
-			*pmDataBuf = *shifter;
-		}
-		pmDataBuf = (u32*)(tempBuffer + PAGE_NUM_PER_BLOCK * sizeof(u32));
+	if((blockNo != 0xffffffff) && (blockMap->bmEntry[dieNo][blockNo].currentPage != 0xffff))
+	{
+		blockMap->bmEntry[dieNo][blockNo].currentPage++;
+#if MAP_CACHE_ENABLE
+		pmAddrForCurrentBlock = (u32)pageMap->lpn[dieNo][stream];
+#else
+		pmAddrForCurrentBlock = PAGE_MAP_ADDR + sizeof(u32)*(dieNo*SUB_PAGE_NUM_PER_DIE + blockNo*SUB_PAGE_NUM_PER_BLOCK);
+#endif
+
+		// the buffer of the die may still be in program for the page map of another stream
+		WaitWayFree(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM);
+		CopyData(tempBuffer, pmAddrForCurrentBlock, sizeof(u32) * blockMap->bmEntry[dieNo][blockNo].currentPage * SUB_PAGE_NUM_PER_PAGE);
+		pmDataBuf = (u32*)(tempBuffer + P2L_CI_OFFSET);
 		*pmDataBuf = ++ciMap->ciEntry[dieNo];	// insert closed index
 
-		WaitWayFree(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM);
-		SsdProgram(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM, ((dieBlock->dieEntry[dieNo].currentBlock * PAGE_NUM_PER_BLOCK)
-											+ blockMap->bmEntry[dieNo][dieBlock->dieEntry[dieNo].currentBlock].currentPage), tempBuffer);
-		WaitWayFree(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM);
+		// write sequence of each page orders copies of a sub-page across open blocks at recovery
+		CopyData(tempBuffer + P2L_SEQ_OFFSET, (u32)seqMap->seq[dieNo][stream], sizeof(u32) * blockMap->bmEntry[dieNo][blockNo].currentPage);
+
+		// torn or stale page map page is detected by CRC32C at recovery
+		pmDataBuf = (u32*)(tempBuffer + P2L_CRC_OFFSET);
+		*pmDataBuf = ~Crc32c(CRC32C_INIT, tempBuffer, P2L_CRC_OFFSET);
+
+		// the die is not waited for, dies closing blocks of a sequential stream program their page map pages together
+		IoProgram(dieNo, IO_CLASS_META, ((blockNo * PAGE_NUM_PER_BLOCK)
+											+ blockMap->bmEntry[dieNo][blockNo].currentPage), tempBuffer);
+
+		if(blockMap->bmEntry[dieNo][blockNo].currentPage == (PAGE_NUM_PER_BLOCK - 1))
+			CloseBlock(dieNo, stream);
 	}
 }
 
 void PageMapFlushForOpenBlock() //save page map of open block
 {
-	u32 dieNo;
+	u32 dieNo, stream;
 
-	// close open-block by writing pageMap
-	for(dieNo=0; dieNo<DIE_NUM; dieNo++)
-	{
-		PageMapFlushForCurrentBlock(dieNo, GC_BUFFER_ADDR);
-		//adjust current page for next FindFreePage
-		if(blockMap->bmEntry[dieNo][dieBlock->dieEntry[dieNo].currentBlock].currentPage == (PAGE_NUM_PER_BLOCK - 1))
-		{
-			//find free block
-			xil_printf("[ Open block(%d die %d block) becomes closed block. ]\r\n", dieNo,dieBlock->dieEntry[dieNo].currentBlock);
+	ReleaseGcVictim();
 
-			dieBlock->dieEntry[dieNo].currentBlock++;
-			int i;
-			for(i=dieBlock->dieEntry[dieNo].currentBlock ; i<(dieBlock->dieEntry[dieNo].currentBlock + BLOCK_NUM_PER_DIE) ; i++)
-			{
-				if((blockMap->bmEntry[dieNo][i % BLOCK_NUM_PER_DIE].free) && (!blockMap->bmEntry[dieNo][i % BLOCK_NUM_PER_DIE].bad))
-				{
-					blockMap->bmEntry[dieNo][i % BLOCK_NUM_PER_DIE].free = 0;
-					dieBlock->dieEntry[dieNo].currentBlock = i % BLOCK_NUM_PER_DIE;
+	// close open-block by writing pageMap, a block filled up is reopened by the next FindFreePage
+	// all dies program the page map of a stream at once
+	for(stream=0; stream<STREAM_NUM; stream++)
+		for(dieNo=0; dieNo<DIE_NUM; dieNo++)
+			PageMapFlushForCurrentBlock(dieNo, stream, P2L_BUFFER_ADDR + dieNo*PAGE_SIZE);
+
+	for(dieNo=0; dieNo<DIE_NUM; dieNo++)
+		WaitWayFree(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM);
 
-					blockMap->bmEntry[dieNo][dieBlock->dieEntry[dieNo].currentBlock].currentPage = 0xffff;
-					break;
-				}
-			}
-			if(i==(dieBlock->dieEntry[dieNo].currentBlock + BLOCK_NUM_PER_DIE))
-			{
-				dieBlock->dieEntry[dieNo].currentBlock = GarbageCollection(dieNo);
-				--blockMap->bmEntry[dieNo][dieBlock->dieEntry[dieNo].currentBlock].currentPage;
-				PageMapFlushForCurrentBlock(dieNo, GC_BUFFER_ADDR);
-			}
-		}
-	}
 	xil_printf("[ Close open-block by writing page map. ]\r\n");
 }
 
@@ -777,9 +1738,8 @@ void MetadataFlush()
 	u32 tempBuffer, diePpn, dieNo;
 	int loop;
 
-	// flush blockmap, dieblcok, gcmap, cimap
-	loop = sizeof(struct bmEntry) * BLOCK_NUM_PER_SSD + sizeof(struct dieEntry) * DIE_NUM
-								+ sizeof(struct gcEntry) * DIE_NUM*(PAGE_NUM_PER_BLOCK + 1) + sizeof(u32) * DIE_NUM;
+	// flush blockmap, dieblcok, gcmap, cimap, and translation directory of cached mapping table
+	loop = METADATA_SIZE;
 	dieNo = METADATA_BLOCK_PPN % DIE_NUM;
 	diePpn = METADATA_BLOCK_PPN / DIE_NUM + BLOCK_NUM_PER_SSD / PAGE_SIZE + 1;
 	tempBuffer = BLOCK_MAP_ADDR;
@@ -787,7 +1747,7 @@ void MetadataFlush()
 	while(loop>0)
 	{
 		WaitWayFree(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM);
-		SsdProgram(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM, diePpn, tempBuffer);
+		IoProgram(dieNo, IO_CLASS_META, diePpn, tempBuffer);
 		WaitWayFree(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM);
 
 		diePpn++;
@@ -795,22 +1755,84 @@ void MetadataFlush()
 		loop -= PAGE_SIZE;
 	}
 
+#if !MAP_CACHE_ENABLE
+	// extents collected by ExtentMapFlush follow in order of pages of the block
+	loop = (1 + 3*(*(u32*)EXTENT_BUF_ADDR)) * sizeof(u32);
+	diePpn = EXTENT_PPN;
+	tempBuffer = EXTENT_BUF_ADDR;
+
+	while(loop>0)
+	{
+		WaitWayFree(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM);
+		IoProgram(dieNo, IO_CLASS_META, diePpn, tempBuffer);
+		WaitWayFree(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM);
+
+		diePpn++;
+		tempBuffer += PAGE_SIZE;
+		loop -= PAGE_SIZE;
+	}
+#endif
+
 	xil_printf("[ Meta data flush is done. ]\r\n");
 }
 
+// extents are programmed after meta data by MetadataFlush
+void ExtentMapFlush()
+{
+#if !MAP_CACHE_ENABLE
+	u32 dieNo, dieLpn, extentCnt, start, ppn;
+	u32* extent = (u32*)EXTENT_BUF_ADDR;
+
+	// collect runs of zero-mapped and shared sub-pages, must precede the flush of packing buffers
+	extentCnt = 0;
+	for(dieNo=0; dieNo<DIE_NUM; dieNo++)
+	{
+		dieLpn = 0;
+		while(dieLpn < SUB_PAGE_NUM_PER_DIE)
+		{
+			ppn = GetL2P(dieNo, dieLpn);
+			if((ppn != ZERO_4BYTE) && !IS_DEDUP_ID(ppn))
+			{
+				dieLpn++;
+				continue;
+			}
+
+			if(extentCnt == EXTENT_NUM)
+			{
+				// no room for more extents, the sub-page is programmed as data
+				ReadSubPage(dieNo, dieLpn, DEDUP_BUFFER_ADDR);
+				CopyData(AllocPackSlot(dieNo, dieLpn), DEDUP_BUFFER_ADDR, SUB_PAGE_SIZE);
+				dieLpn++;
+				continue;
+			}
+
+			start = dieLpn;
+			do
+				dieLpn++;
+			while((dieLpn < SUB_PAGE_NUM_PER_DIE) && (GetL2P(dieNo, dieLpn) == ((ppn == ZERO_4BYTE) ? ppn : ppn + dieLpn - start)));
+
+			extent[1 + 3*extentCnt] = dieNo * SUB_PAGE_NUM_PER_DIE + start;
+			extent[2 + 3*extentCnt] = dieLpn - start;
+			extent[3 + 3*extentCnt] = ppn;
+			extentCnt++;
+		}
+	}
+	extent[0] = extentCnt;
+
+	xil_printf("[ L2P extents are collected. %d extents ]\r\n", extentCnt);
+#endif
+}
+
 int CheckMetadata()
 {
-	u32* check4Byte = (u32*)(RAM_DISK_BASE_ADDR);
 	u32 dieNo, diePpn;
 
 	dieNo = METADATA_BLOCK_PPN % DIE_NUM;
 	diePpn = METADATA_BLOCK_PPN / DIE_NUM + BLOCK_NUM_PER_SSD / PAGE_SIZE + 1;
-	SsdRead(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM, diePpn, RAM_DISK_BASE_ADDR);
+	IoRead(dieNo, IO_CLASS_META, diePpn, RAM_DISK_BASE_ADDR);
 	WaitWayFree(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM);
 
-	if(*check4Byte != EMPTY_4BYTE)
-		return 1;
-	return 0;
+	return !IsDataFilled(RAM_DISK_BASE_ADDR, PAGE_SIZE, EMPTY_4BYTE);
 }
 
 void RecoverMetadata()
@@ -818,8 +1840,7 @@ void RecoverMetadata()
 	u32 dieNo, blockNo, badBlockCount, diePpn;
 	u32 tempBuffer = BLOCK_MAP_ADDR;
 
-	int loop = sizeof(struct bmEntry) * BLOCK_NUM_PER_SSD + sizeof(struct dieEntry) * DIE_NUM
-					+ sizeof(struct gcEntry) * DIE_NUM*(PAGE_NUM_PER_BLOCK + 1) + sizeof(u32) * DIE_NUM;
+	int loop = METADATA_SIZE;
 
 	dieNo = METADATA_BLOCK_PPN % DIE_NUM;
 	diePpn = METADATA_BLOCK_PPN / DIE_NUM + BLOCK_NUM_PER_SSD / PAGE_SIZE + 1;
@@ -827,13 +1848,15 @@ void RecoverMetadata()
 	while(loop > 0)
 	{
 		WaitWayFree(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM);
-		SsdRead(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM, diePpn, tempBuffer);
+		IoRead(dieNo, IO_CLASS_META, diePpn, tempBuffer);
 		WaitWayFree(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM);
 
 		diePpn++;
 		tempBuffer += PAGE_SIZE;
 		loop -= PAGE_SIZE;
 	}
+	RecoverSmart();
+	ReadExtentMap();	// metadata block is erased by bad block table back-up
 	BadBlockTableBackup();
 
 	blockMap = (struct bmArray*)(BLOCK_MAP_ADDR);
@@ -861,7 +1884,7 @@ void BadBlockTableBackup()
 	tempBuffer = GC_BUFFER_ADDR;
 	while(loop > 0)
 	{
-		SsdRead(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM, diePpn, tempBuffer);
+		IoRead(dieNo, IO_CLASS_META, diePpn, tempBuffer);
 		WaitWayFree(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM);
 
 		diePpn++;
@@ -870,8 +1893,9 @@ void BadBlockTableBackup()
 	}
 
 	blockMap->bmEntry[dieNo][blockNo].eraseCnt++;
+	SmartErase(dieNo, blockNo);
 	WaitWayFree(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM);
-	SsdErase(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM, blockNo);
+	IoErase(dieNo, IO_CLASS_META, blockNo);
 	WaitWayFree(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM);
 
 	// save bad block mark
@@ -880,7 +1904,7 @@ void BadBlockTableBackup()
 	tempBuffer = GC_BUFFER_ADDR;
 	while(loop>0)
 	{
-		SsdProgram(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM, diePpn, tempBuffer);
+		IoProgram(dieNo, IO_CLASS_META, diePpn, tempBuffer);
 		WaitWayFree(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM);
 
 		diePpn++;
@@ -893,15 +1917,19 @@ void BadBlockTableBackup()
 
 void RecoverPageMap()
 {
+#if !MAP_CACHE_ENABLE
 	u32 pageNo, blockNo;
+#endif
+	u32 stream;
 	int blockCount, dieCount, pageCount;
-	u32 dieLpn, diePpn;
-	u32* closedIndex;
+	u32 dieLpn, diePpn, ppn;
+	u32* pageSeq;
 	u32* shifter;
 
 	pageMap = (struct pmArray*)(PAGE_MAP_ADDR);
 	blockMap = (struct bmArray*)(BLOCK_MAP_ADDR);
 	ciBufMap = (struct ciBufArray*)(CI_BUF_MAP_ADDR);
+	seqMap = (struct seqArray*)(SEQ_MAP_ADDR);
 
 	dieBlock = (struct dieArray*)(DIE_MAP_ADDR);//test
 
@@ -909,10 +1937,12 @@ void RecoverPageMap()
 
 	for(dieCount=0; dieCount < DIE_NUM; dieCount++)
 	{
+#if !MAP_CACHE_ENABLE
 		//	reset ciBufMap
 		for(blockCount=0; blockCount<BLOCK_NUM_PER_DIE; ++blockCount)
-			for(pageCount=0; pageCount<PAGE_NUM_PER_BLOCK; ++pageCount)
+			for(pageCount=0; pageCount<SUB_PAGE_NUM_PER_BLOCK; ++pageCount)
 				ciBufMap->ciBufEntry[blockCount][pageCount] = 0x00000000;
+#endif
 
 		// recover pageMap
 		for(blockCount=BLOCK_NUM_PER_DIE-1; blockCount >=0; --blockCount)
@@ -921,40 +1951,211 @@ void RecoverPageMap()
 																		&& (blockMap->bmEntry[dieCount][blockCount].currentPage != 0xffff))
 			{
 				diePpn = blockCount*PAGE_NUM_PER_BLOCK + blockMap->bmEntry[dieCount][blockCount].currentPage;
-				SsdRead(dieCount % CHANNEL_NUM, dieCount / CHANNEL_NUM, diePpn, RAM_DISK_BASE_ADDR);
+				IoRead(dieCount, IO_CLASS_META, diePpn, RAM_DISK_BASE_ADDR);
 				WaitWayFree(dieCount % CHANNEL_NUM, dieCount / CHANNEL_NUM);
 
-				closedIndex = (u32*)(RAM_DISK_BASE_ADDR + sizeof(u32)*PAGE_NUM_PER_BLOCK);
+				if(*(u32*)(RAM_DISK_BASE_ADDR + P2L_CRC_OFFSET) != ~Crc32c(CRC32C_INIT, RAM_DISK_BASE_ADDR, P2L_CRC_OFFSET))
+				{
+					xil_printf("[WARNING] Page map of %d die %d block is broken. [WARNING]\r\n", dieCount, blockCount);
+					continue;
+				}
+
+				pageSeq = (u32*)(RAM_DISK_BASE_ADDR + P2L_SEQ_OFFSET);
+
+				// open blocks continue their write sequence after recovery
+				for(stream=0; stream<STREAM_NUM; stream++)
+					if(dieBlock->dieEntry[dieCount].currentBlock[stream] == (u32)blockCount)
+						CopyData((u32)seqMap->seq[dieCount][stream], (u32)pageSeq, sizeof(u32)*blockMap->bmEntry[dieCount][blockCount].currentPage);
 
-				for(pageCount=blockMap->bmEntry[dieCount][blockCount].currentPage-1; pageCount >= 0; pageCount--)
+				for(pageCount=blockMap->bmEntry[dieCount][blockCount].currentPage*SUB_PAGE_NUM_PER_PAGE-1; pageCount >= 0; pageCount--)
 				{
 					//Check closed index
 					shifter = (u32*)(RAM_DISK_BASE_ADDR + pageCount*sizeof(u32));
-					dieLpn = (*shifter)>>1;
+					dieLpn = *shifter;
 
-					if(dieLpn != 0x7fffffff)
+					if(dieLpn == CONTAINER_4BYTE)
 					{
-						blockNo = dieLpn / PAGE_NUM_PER_BLOCK;
-						pageNo = dieLpn % PAGE_NUM_PER_BLOCK;
-
-						if(ciBufMap->ciBufEntry[blockNo][pageNo] < *closedIndex)
+						// slots of a container page are recovered from its header once for both sub-pages
+						ppn = blockCount*SUB_PAGE_NUM_PER_BLOCK + pageCount;
+						SetP2L(dieCount, ppn, dieLpn);
+						if(pageCount % SUB_PAGE_NUM_PER_PAGE == 0)
+							RecoverContainer(dieCount, ppn / SUB_PAGE_NUM_PER_PAGE, pageSeq[pageCount / SUB_PAGE_NUM_PER_PAGE]);
+					}
+					else if(dieLpn != 0xffffffff)
+					{
+						ppn = blockCount*SUB_PAGE_NUM_PER_BLOCK + pageCount;
+#if MAP_CACHE_ENABLE
+						// translation pages flushed at shutdown hold the latest mapping
+						SetP2L(dieCount, ppn, dieLpn);
+						if(GetL2P(dieCount, dieLpn) == ppn)
+							SetValid(dieCount, ppn);
+#else
+						blockNo = dieLpn / SUB_PAGE_NUM_PER_BLOCK;
+						pageNo = dieLpn % SUB_PAGE_NUM_PER_BLOCK;
+
+						// shared sub-page is validated by RecoverDedupMap
+						// data beyond the capacity of the last boot was unmapped then and stays invalid
+						if(IS_DEDUP_ID(dieLpn))
+							SetP2L(dieCount, ppn, dieLpn);
+						else if(BeyondCapacity(dieCount, dieLpn))
+							SetP2L(dieCount, ppn, dieLpn);
+						else if(ciBufMap->ciBufEntry[blockNo][pageNo] < pageSeq[pageCount / SUB_PAGE_NUM_PER_PAGE])
 						{
-							if(pageMap->pmEntry[dieCount][dieLpn].ppn != 0xffffffff)
-								pageMap->pmEntry[dieCount][pageMap->pmEntry[dieCount][dieLpn].ppn].valid = 0; //invalid previous data
+							if(GetL2P(dieCount, dieLpn) != 0xffffffff)
+								ClearRecoveredPpn(dieCount, GetL2P(dieCount, dieLpn)); //invalid previous data
 
-							pageMap->pmEntry[dieCount][dieLpn].ppn = blockCount*PAGE_NUM_PER_BLOCK + pageCount;
-							pageMap->pmEntry[dieCount][blockCount*PAGE_NUM_PER_BLOCK + pageCount].lpn = dieLpn;
-							pageMap->pmEntry[dieCount][blockCount*PAGE_NUM_PER_BLOCK + pageCount].valid = 1;
+							SetL2P(dieCount, dieLpn, ppn);
+							SetP2L(dieCount, ppn, dieLpn);
+							SetValid(dieCount, ppn);
 
-							//Save closed index
-							ciBufMap->ciBufEntry[blockNo][pageNo] = *closedIndex;
+							//Save write sequence
+							ciBufMap->ciBufEntry[blockNo][pageNo] = pageSeq[pageCount / SUB_PAGE_NUM_PER_PAGE];
 						}
 						else
-							pageMap->pmEntry[dieCount][blockCount*PAGE_NUM_PER_BLOCK + pageCount].valid = 0;
+							SetP2L(dieCount, ppn, dieLpn);
+#endif
 					}
 				}
 			}
 		}
 	}
+	RecoverExtentMap();
+	RecoverDedupMap();
+
 	xil_printf("[ Page map is recovered. ]\r\n");
 }
+
+void ReadExtentMap()
+{
+#if !MAP_CACHE_ENABLE
+	u32 dieNo, diePpn;
+	u32* extent = (u32*)EXTENT_BUF_ADDR;
+	int loop;
+
+	dieNo = METADATA_BLOCK_PPN % DIE_NUM;
+	diePpn = EXTENT_PPN;
+	WaitWayFree(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM);
+	IoRead(dieNo, IO_CLASS_META, diePpn, (u32)extent);
+	WaitWayFree(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM);
+
+	// erased page, no extent was saved
+	if(extent[0] == EMPTY_4BYTE)
+	{
+		extent[0] = 0;
+		return;
+	}
+
+	loop = (1 + 3*extent[0]) * sizeof(u32) - PAGE_SIZE;
+	while(loop > 0)
+	{
+		diePpn++;
+		extent += PAGE_SIZE / sizeof(u32);
+		IoRead(dieNo, IO_CLASS_META, diePpn, (u32)extent);
+		WaitWayFree(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM);
+
+		loop -= PAGE_SIZE;
+	}
+#endif
+}
+
+void RecoverExtentMap()
+{
+#if !MAP_CACHE_ENABLE
+	u32 i, dieNo, dieLpn, startLpn, endLpn, ppn;
+	u32* extent = (u32*)EXTENT_BUF_ADDR;
+
+	// extents override the older data recovered from page maps, shared sub-pages are validated by RecoverDedupMap
+	for(i=0; i<extent[0]; i++)
+	{
+		dieNo = extent[1 + 3*i] / SUB_PAGE_NUM_PER_DIE;
+		startLpn = extent[1 + 3*i] % SUB_PAGE_NUM_PER_DIE;
+		endLpn = startLpn + extent[2 + 3*i];
+
+		for(dieLpn=startLpn; dieLpn<endLpn; dieLpn++)
+		{
+			ppn = GetL2P(dieNo, dieLpn);
+			if(ppn < ZERO_4BYTE)
+				ClearRecoveredPpn(dieNo, ppn);
+
+			if(extent[3 + 3*i] == ZERO_4BYTE)
+				SetL2P(dieNo, dieLpn, ZERO_4BYTE);
+			else
+				SetL2P(dieNo, dieLpn, extent[3 + 3*i] + dieLpn - startLpn);
+		}
+	}
+#endif
+}
+
+// over-provisioning of the next boot, saved with meta data at shutdown
+int SetOverProvision(u32 percent)
+{
+	cfgMap = (struct cfgArray*)(CFG_ADDR);
+
+	if(percent > OVER_PROVISION_MAX)
+		return 0;
+
+	cfgMap->opPercent = percent;
+
+	return 1;
+}
+
+// exported capacity in MB, over-provisioned blocks of all dies are left out
+u32 GetStorageSize()
+{
+	return SSD_SIZE - FREE_BLOCK_SIZE - BAD_BLOCK_SIZE - METADATA_BLOCK_SIZE - TRANS_BLOCK_SIZE - DIE_NUM * OP_BLOCK_NUM * BLOCK_SIZE_MB;
+}
+
+void InitConfig()
+{
+	cfgMap = (struct cfgArray*)(CFG_ADDR);
+
+	cfgMap->magic = CONFIG_MAGIC;
+	cfgMap->opPercent = OVER_PROVISION_PERCENT;
+	cfgMap->reserved = 0;
+
+	OP_BLOCK_NUM = BLOCK_NUM_PER_DIE * cfgMap->opPercent / 100;
+	cfgMap->exportPageNum = GetStorageSize() * Mebibyte / SECTOR_NUM_PER_PAGE;
+
+	xil_printf("[ ssd over-provisioning %d%%. ]\r\n", cfgMap->opPercent);
+}
+
+// sub-page beyond the capacity of the last boot, it was unmapped then and is not remapped at recovery
+int BeyondCapacity(u32 dieNo, u32 dieLpn)
+{
+	cfgMap = (struct cfgArray*)(CFG_ADDR);
+
+	if(cfgMap->magic != CONFIG_MAGIC)
+		return 0;
+
+	return (dieLpn / SUB_PAGE_NUM_PER_PAGE * DIE_NUM + dieNo) >= cfgMap->exportPageNum;
+}
+
+// logical pages beyond the capacity of this boot are unmapped so that GC reclaims their data
+void RecoverConfig()
+{
+	cfgMap = (struct cfgArray*)(CFG_ADDR);
+
+	u32 lpn, exportPageNum;
+	int i;
+
+	// meta data flushed by older firmware has no settings, its capacity had no over-provisioning
+	if(cfgMap->magic != CONFIG_MAGIC)
+	{
+		cfgMap->magic = CONFIG_MAGIC;
+		cfgMap->opPercent = 0;
+		cfgMap->reserved = 0;
+
+		OP_BLOCK_NUM = 0;
+		cfgMap->exportPageNum = GetStorageSize() * Mebibyte / SECTOR_NUM_PER_PAGE;
+	}
+
+	OP_BLOCK_NUM = BLOCK_NUM_PER_DIE * cfgMap->opPercent / 100;
+	exportPageNum = GetStorageSize() * Mebibyte / SECTOR_NUM_PER_PAGE;
+
+	for(lpn=exportPageNum ; lpn<cfgMap->exportPageNum ; lpn++)
+		for(i=0 ; i<SUB_PAGE_NUM_PER_PAGE ; i++)
+			UpdateMetaForOverwrite(lpn % DIE_NUM, lpn / DIE_NUM * SUB_PAGE_NUM_PER_PAGE + i);
+	cfgMap->exportPageNum = exportPageNum;
+
+	xil_printf("[ ssd over-provisioning %d%%. ]\r\n", cfgMap->opPercent);
+}
@@ -32,7 +32,7 @@
 // Module Name: Page Mapping
 // File Name: page_map.h
 //
-// Version: v2.3.0
+// Version: v2.22.0
 //
 // Description:
 //   - define data structure of map tables
@@ -41,6 +41,76 @@
 //////////////////////////////////////////////////////////////////////////////////
 // Revision History:
 //
+// * v2.22.0
+//   - add address of I/O scheduler queues
+//
+// * v2.21.3
+//   - page map keeps P2L entries of open blocks and a page map page cache of each die when the mapping table is cached
+//
+// * v2.21.2
+//   - add check of a sub-page beyond the capacity of the last boot
+//
+// * v2.21.1
+//   - add die of the last GC step
+//
+// * v2.21.0
+//   - add settings saved with meta data, over-provisioning of each die
+//
+// * v2.20.0
+//   - add GC debt of host writes
+//
+// * v2.19.0
+//   - add state of background GC
+//
+// * v2.18.0
+//   - page map buffer of each die so that page map pages of all dies are programmed in parallel
+//
+// * v2.17.0
+//   - add buffers of inline compression
+//
+// * v2.16.0
+//   - add dedup map, fingerprint index and buffer to compare duplicates
+//   - extents saved at shutdown hold dedup ids as well as zero mapping
+//
+// * v2.15.0
+//   - add zero mapping of all-zero sub-pages, shared zero buffer and zero extents saved at shutdown
+//
+// * v2.14.0
+//   - add layout of page map page with CRC32C
+//
+// * v2.13.0
+//   - block lists are linked by 16-bit block indices
+//   - add bitmap of non-empty GC victim lists
+//
+// * v2.12.0
+//   - add open blocks and packing buffers of write streams
+//   - add write sequences of pages in open blocks
+//
+// * v2.11.0
+//   - add free block list of each die
+//
+// * v2.10.0
+//   - add wear leveling buffer
+//
+// * v2.9.0
+//   - SMART counters are kept in meta data
+//
+// * v2.8.0
+//   - die buffers are replaced with a write buffer pool, host data is programmed without copy
+//
+// * v2.7.0
+//   - add read-ahead buffer
+//
+// * v2.6.0
+//   - page map holds P2L entries only, validity is kept in per-block bitmaps
+//
+// * v2.5.0
+//   - L2P table is separated from page map to support cached mapping table
+//
+// * v2.4.0
+//   - map tables are indexed by sub-page to support 4KB mapping granularity
+//   - replace page buffer with per-die packing buffers
+//
 // * v2.3.0
 //   - add die buffer to support channel/way interleaving between different write requests
 //
@@ -69,35 +139,61 @@
 
 #include "host_controller.h"
 #include "ftl.h"
+#include "map_cache.h"
+#include "read_ahead.h"
+#include "smart.h"
+#include "wear_level.h"
+#include "data_kernel.h"
+#include "dedup.h"
+#include "compress.h"
+#include "io_sched.h"
 
-struct pmEntry {
-	u32 ppn;	// Physical Page Number (PPN) to which a logical page is mapped
-
-	u32 valid	: 1;	// validity of a physical page
-	u32 lpn		: 31;	// Logical Page Number (LPN) of a physical page
+// P2L entries are indexed by physical sub-page, ppn = physical page * SUB_PAGE_NUM_PER_PAGE + slot in the page
+// P2L entries are accessed by GetP2L() and SetP2L(), L2P entries by GetL2P() and SetL2P()
+#if MAP_CACHE_ENABLE
+// only open blocks keep P2L entries in DRAM, a closed block has them in its page map page read on demand
+struct pmArray {
+	u32 lpn[DIE_NUM][STREAM_NUM][SUB_PAGE_NUM_PER_BLOCK];	// Logical sub-page Number (LPN) of a physical sub-page of each open block
+	u32 cacheBlock[DIE_NUM];	// closed block whose page map page is at P2L_CACHE_ADDR, 0xffffffff for none
 };
-
+#else
 struct pmArray {
-	struct pmEntry pmEntry[DIE_NUM][PAGE_NUM_PER_DIE];
+	u32 lpn[DIE_NUM][SUB_PAGE_NUM_PER_DIE];	// Logical sub-page Number (LPN) of a physical sub-page
+};
+#endif
+
+// validity of physical sub-pages, a bit per sub-page packed in words of each block
+#define VALID_WORD_NUM_PER_BLOCK	((SUB_PAGE_NUM_PER_BLOCK + 31) / 32)
+
+struct vmArray {
+	u32 vmEntry[DIE_NUM][BLOCK_NUM_PER_DIE][VALID_WORD_NUM_PER_BLOCK];
 };
 
+// blocks of a die are linked in free list or GC victim lists by 16-bit indices
+#define BLOCK_NONE	0xffff	// end of block list
+
 struct bmEntry {
 	u32 bad				: 1;
 	u32 free			: 1;
-	u32 eraseCnt		: 30;
+	u32 open			: 1;	// open block of a write stream, kept out of GC victim lists
+	u32 eraseCnt		: 29;
 	u32 invalidPageCnt	: 16;
 	u32 currentPage		: 16;
-	u32 prevBlock;
-	u32 nextBlock;
+	u16 prevBlock;
+	u16 nextBlock;
+	u32 writeSeq;	// write sequence of the die at the last program, tells age of data
 };
 
 struct bmArray {
 	struct bmEntry bmEntry[DIE_NUM][BLOCK_NUM_PER_DIE];
 };
 
+// free blocks of a die are linked through prevBlock/nextBlock in ascending order of erase count
 struct dieEntry {
-	u32 currentBlock;
-	u32 freeBlock;
+	u32 currentBlock[STREAM_NUM];	// open block of each write stream, 0xffffffff for none
+	u32 freeBlock;	// reserved for GC migration when no free block is left
+	u16 freeListHead;	// least worn free block
+	u16 freeListTail;
 };
 
 struct dieArray {
@@ -105,24 +201,89 @@ struct dieArray {
 };
 
 struct gcEntry {
-	u32 head;
-	u32 tail;
+	u16 head;
+	u16 tail;
 };
 
+// a bit per victim list of each invalid sub-page count is set while the list is not empty
+// a summary bit per bitmap word is set while the word is not zero, the fullest list is found by two CLZs
+#define GC_BITMAP_WORD_NUM	((SUB_PAGE_NUM_PER_BLOCK + 1 + 31) / 32)
+
 struct gcArray {
-	struct gcEntry gcEntry[DIE_NUM][PAGE_NUM_PER_BLOCK+1];
+	struct gcEntry gcEntry[DIE_NUM][SUB_PAGE_NUM_PER_BLOCK+1];
+	u32 bitmap[DIE_NUM][GC_BITMAP_WORD_NUM];
+	u32 summary[DIE_NUM];
 };
 
+// write sequence of each die, stamped on every programmed page and closed index
 struct ciArray {
 	u32 ciEntry[DIE_NUM];
 };
 
+// victim of each die migrated step by step, it is kept open so that invalidation does not relink it
+// free blocks are counted for the trigger, the count is rebuilt from free lists at boot
+struct gcSchedArray {
+	u32 victim[DIE_NUM];	// BLOCK_NONE for none
+	u32 nextPage[DIE_NUM];	// next page of the victim to migrate
+	u32 freeBlockCnt[DIE_NUM];
+	u32 debt[DIE_NUM];	// pages host writes owe to GC, in 1/GC_DEBT_UNIT page
+	u32 bgFreeBlockNum;	// free blocks of a die below which background GC runs, grows with over-provisioning
+	u32 idleDie;	// die to look at first in the next idle step
+	u32 lastDie;	// die of the last step, its program from GC buffers may be in execution
+};
+struct gcSchedArray* gcSched;
+
+#define GC_DEBT_UNIT	256
+
+// settings changed at run time and saved with meta data
+#define CONFIG_MAGIC	0x47464e43	// "CNFG"
+
+struct cfgArray {
+	u32 magic;
+	u32 opPercent;	// over-provisioning of each die in percent, applied at boot
+	u32 exportPageNum;	// logical pages exported since the last boot
+	u32 reserved;
+};
+struct cfgArray* cfgMap;
+
+// write sequences of pages in open blocks, flushed with page map of the block
+// recovery takes the copy with the latest sequence as blocks of different streams are open together
+struct seqArray {
+	u32 seq[DIE_NUM][STREAM_NUM][PAGE_NUM_PER_BLOCK];
+};
+struct seqArray* seqMap;
+
 struct ciBufArray {
-	u32 ciBufEntry[BLOCK_NUM_PER_DIE][PAGE_NUM_PER_BLOCK];
+	u32 ciBufEntry[BLOCK_NUM_PER_DIE][SUB_PAGE_NUM_PER_BLOCK];
 };
 struct ciBufArray* ciBufMap;
 
+// packing buffer gathers sub-pages of a die until a whole page can be programmed
+struct pbEntry {
+	u32 lpn[SUB_PAGE_NUM_PER_PAGE];	// logical sub-page held in each slot
+	u32 slotCnt;	// number of occupied slots
+	u32 bufAddr;	// page buffer taken from write buffer pool, 0xffffffff for none
+};
+
+struct pbArray {
+	struct pbEntry pbEntry[DIE_NUM][STREAM_HOST_NUM];
+};
+struct pbArray* packBuf;
+
+// write buffer pool, host data lands in a page buffer that is programmed as it is
+// a buffer returns to the pool when the program of the die is complete
+#define WRITE_BUFFER_NUM	((STREAM_HOST_NUM + 2) * DIE_NUM)	// at least a buffer per die for programs and for packing of each host stream, and one more
+
+struct wbArray {
+	u32 freeBuf[WRITE_BUFFER_NUM];	// stack of free buffers
+	u32 freeCnt;
+	u32 progBuf[DIE_NUM];	// buffer being programmed at each die, 0xffffffff for none
+	u32 reclaimDie;	// next die to wait for when no buffer is free
+};
+struct wbArray* writeBuf;
+
 struct pmArray* pageMap;
+struct vmArray* validMap;
 struct bmArray* blockMap;
 struct dieArray* dieBlock;
 struct gcArray* gcMap;
@@ -130,58 +291,186 @@ struct ciArray* ciMap;
 
 // memory addresses for map tables
 #define PAGE_MAP_ADDR	(RAM_DISK_BASE_ADDR + (0x1 << 27))
-#define BLOCK_MAP_ADDR	(PAGE_MAP_ADDR + sizeof(struct pmEntry) * PAGE_NUM_PER_SSD)
+#define VALID_MAP_ADDR	(PAGE_MAP_ADDR + sizeof(struct pmArray))
+#define L2P_MAP_ADDR	(VALID_MAP_ADDR + sizeof(struct vmArray))
+#if MAP_CACHE_ENABLE
+// cached translation pages take the place of L2P table
+#define MAP_CACHE_ADDR	L2P_MAP_ADDR
+#define CMT_ADDR		(MAP_CACHE_ADDR + MAP_CACHE_SLOT_NUM * PAGE_SIZE)
+#define BLOCK_MAP_ADDR	(CMT_ADDR + sizeof(struct cmtArray))
+#else
+#define BLOCK_MAP_ADDR	(L2P_MAP_ADDR + sizeof(struct l2pArray))
+#endif
 #define DIE_MAP_ADDR	(BLOCK_MAP_ADDR + sizeof(struct bmEntry) * BLOCK_NUM_PER_SSD)
 #define GC_MAP_ADDR		(DIE_MAP_ADDR + sizeof(struct dieEntry) * DIE_NUM)
-#define CI_ADDR			(GC_MAP_ADDR + sizeof(struct gcEntry) * DIE_NUM*(PAGE_NUM_PER_BLOCK + 1))
+#define CI_ADDR			(GC_MAP_ADDR + sizeof(struct gcArray))
+#if MAP_CACHE_ENABLE
+#define GTD_ADDR		(CI_ADDR + sizeof(u32) * DIE_NUM)
+#define TRANS_MAP_ADDR	(GTD_ADDR + sizeof(struct gtdArray))
+#define SMART_ADDR		((TRANS_MAP_ADDR + sizeof(struct tbArray) + 7) & ~0x7)
+#else
+#define SMART_ADDR		((CI_ADDR + sizeof(u32) * DIE_NUM + 7) & ~0x7)
+#endif
+#if DEDUP_ENABLE
+#define DEDUP_MAP_ADDR	(SMART_ADDR + sizeof(struct smartArray))
+#define CFG_ADDR		(DEDUP_MAP_ADDR + sizeof(struct dedupArray))
+#else
+#define CFG_ADDR		(SMART_ADDR + sizeof(struct smartArray))
+#endif
+#define PACK_MAP_ADDR	(CFG_ADDR + sizeof(struct cfgArray))
 
-// Die buffer to guarantee completion of each die
-#define DIE_BUFFER_ADDR			(CI_ADDR + sizeof(u32)*DIE_NUM)
+// meta data from block map to packing buffer map are flushed at shutdown
+#define METADATA_SIZE	(PACK_MAP_ADDR - BLOCK_MAP_ADDR)
+
+// write buffer pool
+#define WRITE_MAP_ADDR			(PACK_MAP_ADDR + sizeof(struct pbArray))
+#define WRITE_BUFFER_ADDR		(WRITE_MAP_ADDR + sizeof(struct wbArray))
 
 // memory address of buffer for GC migration
-#define GC_BUFFER_ADDR			(DIE_BUFFER_ADDR + DIE_NUM*PAGE_SIZE)
+#define GC_BUFFER_ADDR			(WRITE_BUFFER_ADDR + WRITE_BUFFER_NUM*PAGE_SIZE)
+
+// buffer to pack valid sub-pages during GC migration, placed after bad block marks gathered at GC buffer
+#define GC_PACK_BUFFER_ADDR		(GC_BUFFER_ADDR + (DIE_NUM*BLOCK_NUM_PER_DIE + PAGE_SIZE - 1) / PAGE_SIZE * PAGE_SIZE)
+
+// buffer of each die to read a page holding a requested sub-page
+#define SUB_PAGE_BUFFER_ADDR	(GC_PACK_BUFFER_ADDR + PAGE_SIZE)
+
+// buffer for compaction of translation blocks
+#define TRANS_BUFFER_ADDR		(SUB_PAGE_BUFFER_ADDR + DIE_NUM*PAGE_SIZE)
+
+// read-ahead buffer and its slot table
+#define RA_BUFFER_ADDR			(TRANS_BUFFER_ADDR + PAGE_SIZE)
+#define RA_MAP_ADDR				(RA_BUFFER_ADDR + READ_AHEAD_SLOT_NUM*PAGE_SIZE)
+
+// buffer of cold data moved by static wear leveling and its state
+#define WL_BUFFER_ADDR			((RA_MAP_ADDR + sizeof(struct raArray) + PAGE_SIZE - 1) / PAGE_SIZE * PAGE_SIZE)
+#define WL_MAP_ADDR				(WL_BUFFER_ADDR + PAGE_SIZE)
+
+// page map of an open block is gathered in the buffer of its die, which is held until the die finishes the program
+#define P2L_BUFFER_ADDR			((WL_MAP_ADDR + sizeof(struct wlArray) + PAGE_SIZE - 1) / PAGE_SIZE * PAGE_SIZE)
+#define SEQ_MAP_ADDR			(P2L_BUFFER_ADDR + DIE_NUM*PAGE_SIZE)
+
+// page map page of a closed block read for its P2L entries by each die when the mapping table is cached
+#define P2L_CACHE_ADDR			((SEQ_MAP_ADDR + sizeof(struct seqArray) + PAGE_SIZE - 1) / PAGE_SIZE * PAGE_SIZE)
+
+// page of zeros, source of host transfer for unmapped and zero-mapped pages
+#define ZERO_BUFFER_ADDR		(P2L_CACHE_ADDR + DIE_NUM*PAGE_SIZE)
+
+// page read from flash to compare with a duplicate candidate, and fingerprint index
+#define DEDUP_BUFFER_ADDR		(ZERO_BUFFER_ADDR + PAGE_SIZE)
+#define FP_INDEX_ADDR			(DEDUP_BUFFER_ADDR + PAGE_SIZE)
+
+// open container page of each die, page compressed or decompressed, and live counts of container pages
+#define COMP_BUFFER_ADDR		((FP_INDEX_ADDR + sizeof(struct fpArray) + PAGE_SIZE - 1) / PAGE_SIZE * PAGE_SIZE)
+#define COMP_WORK_ADDR			(COMP_BUFFER_ADDR + DIE_NUM*PAGE_SIZE)
+#define COMP_MAP_ADDR			(COMP_WORK_ADDR + PAGE_SIZE)
+
+// state of background GC and queues of the I/O scheduler
+#define GC_SCHED_ADDR			((COMP_MAP_ADDR + sizeof(struct compArray) + 7) & ~0x7)
+#define IO_SCHED_ADDR			(GC_SCHED_ADDR + sizeof(struct gcSchedArray))
+
+// page map page programmed at the end of a block, P2L entries, closed index, write sequence of pages and CRC32C of them
+#define P2L_CI_OFFSET			(SUB_PAGE_NUM_PER_BLOCK * sizeof(u32))
+#define P2L_SEQ_OFFSET			(P2L_CI_OFFSET + sizeof(u32))
+#define P2L_CRC_OFFSET			(P2L_SEQ_OFFSET + PAGE_NUM_PER_BLOCK * sizeof(u32))
 
 // Closed index buffer to recover page map
 #define CI_BUF_MAP_ADDR			(RAM_DISK_BASE_ADDR + PAGE_SIZE)
 
+// L2P entries of zero-mapped and shared sub-pages are not in any page map page, they are saved at shutdown
+// in the pages of metadata block following meta data, the first word is the number of extents
+// an extent is start, count and L2P entry of the start, ZERO_4BYTE for all or a dedup id increasing by one
+#define EXTENT_BUF_ADDR			(CI_BUF_MAP_ADDR + sizeof(struct ciBufArray))
+#define EXTENT_PPN				(METADATA_BLOCK_PPN / DIE_NUM + BLOCK_NUM_PER_SSD / PAGE_SIZE + 1 + (METADATA_SIZE + PAGE_SIZE - 1) / PAGE_SIZE)
+#define EXTENT_PAGE_NUM			(PAGE_NUM_PER_BLOCK - EXTENT_PPN % PAGE_NUM_PER_BLOCK)
+#define EXTENT_NUM				((EXTENT_PAGE_NUM * PAGE_SIZE / sizeof(u32) - 1) / 3)
+
 #define BAD_BLOCK_MARK_POSITION	(7972)
 #define METADATA_BLOCK_PPN	 	0x00000000 // write metadata to Block0 of Die0
 #define EMPTY_4BYTE				0xffffffff
+#define BUFFERED_4BYTE			0xfffffffe // ppn of a logical sub-page held in a packing buffer
+#define ZERO_4BYTE				0xfffffffd // ppn of a logical sub-page whose data is all zero, not programmed
 #define EMPTY_BYTE				0xff
 
 
 extern u32 BAD_BLOCK_SIZE;
-
-// buffered LPN in the page buffer
-u32 pageBufLpn;
+extern u32 OP_BLOCK_NUM;
 
 void InitPageMap();
 void InitBlockMap();
 void InitDieBlock();
 void InitGcMap();
 void InitCiMap();
+void InitPackBuf();
+void InitWriteBuf();
 
-int FindFreePage(u32 dieNo);
+int FindFreePage(u32 dieNo, u32 stream);
+u32 OpenBlock(u32 dieNo, u32 stream);
+void CloseBlock(u32 dieNo, u32 stream);
+u32 ClassifyStream(u32 dieNo, u32 dieLpn);
 int PrePmRead(P_HOST_CMD hostCmd, u32 bufferAddr);
 int PmRead(P_HOST_CMD hostCmd, u32 bufferAddr);
+u32 PmReadPage(u32 lpn, u32 tempBuffer, u32 startSect, u32 endSect);
 int PmWrite(P_HOST_CMD hostCmd, u32 bufferAddr);
 
+u32 AllocFreeBlock(u32 dieNo);
+void PutFreeBlock(u32 dieNo, u32 blockNo);
+
 void EraseBlock(u32 dieNo, u32 blockNo);
-u32 GarbageCollection(u32 dieNo);
+void GarbageCollection(u32 dieNo);
+void InitGcSched();
+int StartGcVictim(u32 dieNo, u32 minInvalid);
+int GcStep(u32 dieNo, u32 pageNum);
+int GcNeeded(u32 dieNo);
+void GcWriteStep(u32 dieNo);
+void GcIdle();
+void ReleaseGcVictim();
+void FlushGcPackBuf(u32 dieNo, u32* lpn);
 
 void CheckBadBlock();
-int CountBits(u8 i);
 
-void FlushPageBuf(u32 lpn, u32 bufAddr);
-void UpdateMetaForOverwrite(u32 lpn);
+u32 AllocWriteBuf();
+void ReleaseWriteBuf(u32 dieNo);
+void FreeWriteBuf(u32 bufAddr);
+void ProgramWriteBuf(u32 dieNo, u32 ppn, u32 bufAddr);
+
+int FindPackSlot(u32 dieNo, u32 stream, u32 dieLpn);
+u32 FindPackStream(u32 dieNo, u32 dieLpn);
+void ReadSubPage(u32 dieNo, u32 dieLpn, u32 bufAddr);
+u32 AllocPackSlot(u32 dieNo, u32 dieLpn);
+void PackSubPage(u32 dieNo, u32 dieLpn, u32 bufAddr);
+void WriteZeroSubPage(u32 dieNo, u32 dieLpn);
+void FlushPackBuf(u32 dieNo, u32 stream);
+void FlushAllPackBuf();
+void UpdateMetaForProgram(u32 dieNo, u32 ppn, u32* lpn);
+void InvalidateSubPage(u32 dieNo, u32 ppn);
+void InsertGcList(u32 dieNo, u32 blockNo);
+void SetGcBitmap(u32 dieNo, u32 invalidPageCnt);
+void ClearGcBitmap(u32 dieNo, u32 invalidPageCnt);
+u32 FindVictimList(u32 dieNo);
+void SetValid(u32 dieNo, u32 ppn);
+void ClearValid(u32 dieNo, u32 ppn);
+int IsValid(u32 dieNo, u32 ppn);
+int CountValid(u32 dieNo, u32 blockNo);
+u32 GetP2L(u32 dieNo, u32 ppn);
+void SetP2L(u32 dieNo, u32 ppn, u32 dieLpn);
+void UpdateMetaForOverwrite(u32 dieNo, u32 dieLpn);
 //void MvData(u32* src, u32* dst, u32 sectSize);
 
-void PageMapFlushForCurrentBlock(u32 dieNo,  u32 tempBuffer);
+void PageMapFlushForCurrentBlock(u32 dieNo, u32 stream, u32 tempBuffer);
 void PageMapFlushForOpenBlock();
 void MetadataFlush();
 int CheckMetadata();
 void RecoverMetadata();
 void BadBlockTableBackup();
 void RecoverPageMap();
+void ExtentMapFlush();
+void ReadExtentMap();
+void RecoverExtentMap();
+void InitConfig();
+void RecoverConfig();
+int SetOverProvision(u32 percent);
+u32 GetStorageSize();
+int BeyondCapacity(u32 dieNo, u32 dieLpn);
 
 #endif /* PAGEMAP_H_ */
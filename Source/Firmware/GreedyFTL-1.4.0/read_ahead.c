@@ -0,0 +1,174 @@
+//////////////////////////////////////////////////////////////////////////////////
+// read_ahead.c for Cosmos OpenSSD
+// Copyright (c) 2014 Hanyang University ENC Lab.
+// Contributed by Yong Ho Song <yhsong@enc.hanyang.ac.kr>
+//                Gyeongyong Lee <gylee@enc.hanyang.ac.kr>
+//				  Jaewook Kwak <jwkwak@@enc.hanyang.ac.kr>
+//
+// This file is part of Cosmos OpenSSD.
+//
+// Cosmos OpenSSD is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3, or (at your option)
+// any later version.
+//
+// Cosmos OpenSSD is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Cosmos OpenSSD; see the file COPYING.
+// If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////
+// Company: ENC Lab. <http://enc.hanyang.ac.kr>
+// Engineer: Gyeongyong Lee <gylee@enc.hanyang.ac.kr>
+//			 Jaewook Kwak <jwkwak@enc.hanyang.ac.kr>
+//
+// Project Name: Cosmos OpenSSD
+// Design Name: Greedy FTL
+// Module Name: Read Ahead
+// File Name: read_ahead.c
+//
+// Version: v1.0.5
+//
+// Description:
+//   - sequential read stream detection
+//   - prefetch of following pages into DRAM on idle dies
+//////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////
+// Revision History:
+//
+// * v1.0.5
+//   - prefetch is read through the I/O scheduler
+//
+// * v1.0.4
+//   - compressed pages are not prefetched
+//
+// * v1.0.3
+//   - shared pages are prefetched from the physical page of their dedup entries
+//
+// * v1.0.2
+//   - zero-mapped pages are not prefetched
+//
+// * v1.0.1
+//   - prefetched page is copied by data kernel
+//
+// * v1.0.0
+//   - First draft
+//////////////////////////////////////////////////////////////////////////////////
+
+#include "read_ahead.h"
+
+#include "lld.h"
+#include "pagemap.h"
+
+void InitReadAhead()
+{
+	raMap = (struct raArray*)(RA_MAP_ADDR);
+
+	int i;
+	for(i=0 ; i<READ_AHEAD_SLOT_NUM ; i++)
+	{
+		raMap->raEntry[i].lpn = 0xffffffff;
+		raMap->raEntry[i].busy = 0;
+	}
+
+	raMap->nextSect = 0xffffffff;
+	raMap->seqCnt = 0;
+	raMap->nextLpn = 0;
+
+	xil_printf("[ ssd read-ahead buffer initialized. ]\r\n");
+}
+
+int ReadAheadHit(u32 lpn, u32 bufAddr)
+{
+	raMap = (struct raArray*)(RA_MAP_ADDR);
+
+	u32 slot = lpn % READ_AHEAD_SLOT_NUM;
+	u32 dieNo = lpn % DIE_NUM;
+
+	if(raMap->raEntry[slot].lpn != lpn)
+		return 0;
+
+	if(raMap->raEntry[slot].busy)
+	{
+		WaitWayFree(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM);
+		raMap->raEntry[slot].busy = 0;
+	}
+
+	CopyData(bufAddr, RA_BUFFER_ADDR + slot*PAGE_SIZE, PAGE_SIZE);
+
+	return 1;
+}
+
+void ReadAheadInvalidate(u32 lpn)
+{
+	raMap = (struct raArray*)(RA_MAP_ADDR);
+
+	// a read in progress to the slot completes before the die accepts the next operation
+	if(raMap->raEntry[lpn % READ_AHEAD_SLOT_NUM].lpn == lpn)
+		raMap->raEntry[lpn % READ_AHEAD_SLOT_NUM].lpn = 0xffffffff;
+}
+
+void ReadAhead(P_HOST_CMD hostCmd)
+{
+	raMap = (struct raArray*)(RA_MAP_ADDR);
+
+	u32 startSect = hostCmd->reqInfo.CurSect;
+	u32 endSect = hostCmd->reqInfo.CurSect + hostCmd->reqInfo.ReqSect;
+	u32 lpn, endLpn, slot, dieNo, dieLpn, ppn;
+	int i;
+
+	// stream detection
+	if(startSect == raMap->nextSect)
+		raMap->seqCnt++;
+	else
+	{
+		raMap->seqCnt = 0;
+		raMap->nextLpn = 0;
+	}
+	raMap->nextSect = endSect;
+
+	if((READ_AHEAD_PAGE_NUM == 0) || (raMap->seqCnt < READ_AHEAD_TRIGGER))
+		return;
+
+	// the page holding the next sector and the following pages are prefetched
+	lpn = endSect / SECTOR_NUM_PER_PAGE;
+	endLpn = lpn + READ_AHEAD_PAGE_NUM;
+	if(raMap->nextLpn > lpn)
+		lpn = raMap->nextLpn;
+	if(endLpn > PAGE_NUM_PER_SSD)
+		endLpn = PAGE_NUM_PER_SSD;
+
+	for( ; lpn<endLpn ; lpn++)
+	{
+		slot = lpn % READ_AHEAD_SLOT_NUM;
+		dieNo = lpn % DIE_NUM;
+		dieLpn = lpn / DIE_NUM * SUB_PAGE_NUM_PER_PAGE;
+
+		if(raMap->raEntry[slot].lpn == lpn)
+			continue;
+
+		// prefetch never waits, the stream continues from here at the next request
+		if(SsdReadChWayStatus(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM) != 0)
+			break;
+
+		// only pages whose sub-pages lie in order in one physical page are prefetched
+		ppn = GetPpn(dieNo, dieLpn);
+		if((ppn >= ZERO_4BYTE) || IS_COMP(ppn) || ((ppn % SUB_PAGE_NUM_PER_PAGE) != 0))
+			continue;
+		for(i=1 ; (i<SUB_PAGE_NUM_PER_PAGE) && (GetPpn(dieNo, dieLpn + i) == ppn + i) ; i++);
+		if(i != SUB_PAGE_NUM_PER_PAGE)
+			continue;
+
+		IoRead(dieNo, IO_CLASS_HOST_READ, ppn / SUB_PAGE_NUM_PER_PAGE, RA_BUFFER_ADDR + slot*PAGE_SIZE);
+		raMap->raEntry[slot].lpn = lpn;
+		raMap->raEntry[slot].busy = 1;
+	}
+
+	raMap->nextLpn = lpn;
+}
@@ -0,0 +1,75 @@
+//////////////////////////////////////////////////////////////////////////////////
+// read_ahead.h for Cosmos OpenSSD
+// Copyright (c) 2014 Hanyang University ENC Lab.
+// Contributed by Yong Ho Song <yhsong@enc.hanyang.ac.kr>
+//                Gyeongyong Lee <gylee@enc.hanyang.ac.kr>
+//			      Jaewook Kwak <jwkwak@enc.hanyang.ac.kr>
+//
+// This file is part of Cosmos OpenSSD.
+//
+// Cosmos OpenSSD is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3, or (at your option)
+// any later version.
+//
+// Cosmos OpenSSD is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Cosmos OpenSSD; see the file COPYING.
+// If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////
+// Company: ENC Lab. <http://enc.hanyang.ac.kr>
+// Engineer: Gyeongyong Lee <gylee@enc.hanyang.ac.kr>
+//			 Jaewook Kwak <jwkwak@enc.hanyang.ac.kr>
+//
+// Project Name: Cosmos OpenSSD
+// Design Name: Greedy FTL
+// Module Name: Read Ahead
+// File Name: read_ahead.h
+//
+// Version: v1.0.0
+//
+// Description:
+//   - define data structure of read-ahead buffer
+//////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////
+// Revision History:
+//
+// * v1.0.0
+//   - First draft
+//////////////////////////////////////////////////////////////////////////////////
+
+#ifndef READ_AHEAD_H_
+#define READ_AHEAD_H_
+
+#include "xil_types.h"
+#include "host_controller.h"
+#include "ftl.h"
+
+// read-ahead slots are direct-mapped by logical page, slot % DIE_NUM equals the die of the page
+struct raEntry {
+	u32 lpn;	// logical page held in the slot, 0xffffffff for an empty slot
+	u32 busy;	// NAND read to the slot may be in progress
+};
+
+struct raArray {
+	struct raEntry raEntry[READ_AHEAD_SLOT_NUM];
+	u32 nextSect;	// first sector following the last read request
+	u32 seqCnt;		// number of consecutive sequential read requests
+	u32 nextLpn;	// first logical page not prefetched yet in the current stream
+};
+
+struct raArray* raMap;
+
+void InitReadAhead();
+int ReadAheadHit(u32 lpn, u32 bufAddr);
+void ReadAheadInvalidate(u32 lpn);
+void ReadAhead(P_HOST_CMD hostCmd);
+
+#endif /* READ_AHEAD_H_ */
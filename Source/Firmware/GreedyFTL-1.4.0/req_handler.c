@@ -34,7 +34,7 @@
 // Module Name: Request Handler
 // File Name: req_handler.c
 //
-// Version: v2.3.0
+// Version: v2.11.1
 //
 // Description:
 //   - Handling request commands.
@@ -43,6 +43,46 @@
 //////////////////////////////////////////////////////////////////////////////////
 // Revision History:
 //
+// * v2.11.1
+//   - completion ring is posted and reset at shutdown so that a reloaded driver finds it at entry 0
+//
+// * v2.11.0
+//   - exported capacity leaves out over-provisioned blocks, vendor command sets over-provisioning of the next boot
+//
+// * v2.10.1
+//   - save L2P extents of zero-mapped and shared sub-pages at shutdown
+//
+// * v2.10.0
+//   - save zero map at shutdown
+//
+// * v2.9.0
+//   - support SMART READ DATA, ENABLE/DISABLE OPERATIONS and RETURN STATUS
+//
+// * v2.8.0
+//   - add vendor command to read latency and die busy statistics
+//
+// * v2.7.0
+//   - FLUSH CACHE drains write buffers, FUA write and write with write cache disabled are durable at completion
+//
+// * v2.6.3
+//   - initialize completion ring
+//
+// * v2.6.2
+//   - invalidate AXI BAR window cache at initialization
+//
+// * v2.6.1
+//   - create descriptor ring of CentralDMA at initialization
+//
+// * v2.6.0
+//   - host DMA of read/write data is moved into PmRead/PmWrite
+//
+// * v2.5.0
+//   - exclude translation blocks from storage size
+//   - flush map cache at shutdown
+//
+// * v2.4.0
+//   - packing buffers replace the page buffer
+//
 // * v2.3.0
 //   - shutdown handling
 //
@@ -81,6 +121,8 @@
 
 #include "ftl.h"
 #include "pageMap.h"
+#include "stats.h"
+#include "smart.h"
 
 extern XAxiPcie devPcie;
 
@@ -113,7 +155,6 @@ XAxiCdma_Config XAxiCdma_ConfigTable[] =
 
 void ReqHandler(void)
 {
-	u32 deviceAddr;
 	u32 reqSize, scatterLength;
 	u32 checkRequest;
 	u32 storageSize;
@@ -124,24 +165,26 @@ void ReqHandler(void)
 	
 	//initialize AXI bridge for PCIe
 	XAxiPcie_CfgInitialize(&devPcie, XAxiPcie_ConfigTable, XPAR_PCI_EXPRESS_BASEADDR);
+	InitBarWindow();
+	InitCompletionRing();
 
 	//initialize CentralDMA
 	XAxiCdma_CfgInitialize(&devCdma, XAxiCdma_ConfigTable, XPAR_AXI_CDMA_0_BASEADDR);
+	InitCdmaBdRing();
 
 	InitIdentifyData(pIdentifyData);
+	InitStats();
 
 	InitNandReset();
 	InitFtlMapTable();
 
 	printf("[ Initialization is completed. ]\r\n");
 
-	storageSize = SSD_SIZE - FREE_BLOCK_SIZE - BAD_BLOCK_SIZE - METADATA_BLOCK_SIZE;
+	storageSize = GetStorageSize();
 	xil_printf("[ Bad block size : %dMB. ]\r\n", BAD_BLOCK_SIZE);
 	xil_printf("[ Storage size : %dMB. ]\r\n",storageSize);
 	Xil_Out32(CONFIG_SPACE_SECTOR_COUNT, storageSize * Mebibyte);
 
-	pageBufLpn = 0xffffffff;	// page buffer initialization
-
 	while(1)
 	{
 
@@ -149,9 +192,14 @@ void ReqHandler(void)
 
 		if(checkRequest == 0)
 		{
-			//shutdown handling
-			FlushPageBuf(pageBufLpn, RAM_DISK_BASE_ADDR);
+			//shutdown handling, staged completions are posted and the ring restarts as the driver does at its next load
+			PostCompletion();
+			InitCompletionRing();
+
+			ExtentMapFlush();
+			FlushAllPackBuf();
 			PageMapFlushForOpenBlock();
+			FlushMapCache();
 			MetadataFlush();
 
 			print("------ Shutdown ------\r\n");
@@ -172,19 +220,19 @@ void ReqHandler(void)
 			hostCmd.CmdStatus = COMMAND_STATUS_SUCCESS;
 			hostCmd.ErrorStatus = IDE_ERROR_NOTHING;
 
-			if((hostCmd.reqInfo.Cmd == IDE_COMMAND_WRITE_DMA) ||  (hostCmd.reqInfo.Cmd == IDE_COMMAND_WRITE))
+			if((hostCmd.reqInfo.Cmd == IDE_COMMAND_WRITE_DMA) ||  (hostCmd.reqInfo.Cmd == IDE_COMMAND_WRITE) || (hostCmd.reqInfo.Cmd == IDE_COMMAND_WRITE_DMA_FUA_EXT))
 			{
 //				xil_printf("write(%d, %d)\r\n", hostCmd.reqInfo.CurSect, hostCmd.reqInfo.ReqSect);
 
 				PrePmRead(&hostCmd, RAM_DISK_BASE_ADDR);
 
-				deviceAddr = RAM_DISK_BASE_ADDR + (hostCmd.reqInfo.CurSect % SECTOR_NUM_PER_PAGE)*SECTOR_SIZE;
-				reqSize = hostCmd.reqInfo.ReqSect * SECTOR_SIZE;
-				scatterLength = hostCmd.reqInfo.HostScatterNum;
-
-				DmaHostToDevice(&hostCmd, deviceAddr, reqSize, scatterLength);
-
+				// data is transferred from host page by page in PmWrite
 				PmWrite(&hostCmd, RAM_DISK_BASE_ADDR);
+				SmartHostWrite(hostCmd.reqInfo.ReqSect);
+
+				// FUA write drains write buffers including data of earlier writes, so does every write without write cache
+				if((hostCmd.reqInfo.Cmd == IDE_COMMAND_WRITE_DMA_FUA_EXT) || !pIdentifyData->CommandSetActive.WriteCache)
+					FlushAllPackBuf();
 
 				CompleteCmd(&hostCmd);
 			}
@@ -193,19 +241,18 @@ void ReqHandler(void)
 			{
 //				xil_printf("read(%d, %d)\r\n", hostCmd.reqInfo.CurSect, hostCmd.reqInfo.ReqSect);
 
+				// data is transferred to host page by page in PmRead
 				PmRead(&hostCmd, RAM_DISK_BASE_ADDR);
 
-				deviceAddr = RAM_DISK_BASE_ADDR + (hostCmd.reqInfo.CurSect % SECTOR_NUM_PER_PAGE)*SECTOR_SIZE;
-				reqSize = hostCmd.reqInfo.ReqSect * SECTOR_SIZE;
-				scatterLength = hostCmd.reqInfo.HostScatterNum;
-
-				DmaDeviceToHost(&hostCmd, deviceAddr, reqSize, scatterLength);
-
 				CompleteCmd(&hostCmd);
 			}
-			else if( hostCmd.reqInfo.Cmd == IDE_COMMAND_FLUSH_CACHE )
+			else if((hostCmd.reqInfo.Cmd == IDE_COMMAND_FLUSH_CACHE) || (hostCmd.reqInfo.Cmd == IDE_COMMAND_FLUSH_CACHE_EXT))
 			{
 				DebugPrint("flush command\r\n");
+
+				// program partially filled pages and wait until all programs are done
+				FlushAllPackBuf();
+
 				CompleteCmd(&hostCmd);
 			}
 			else if( hostCmd.reqInfo.Cmd == IDE_COMMAND_IDENTIFY )
@@ -216,6 +263,26 @@ void ReqHandler(void)
 				DmaDeviceToHost(&hostCmd, IDENTIFY_DEVICE_DATA_BASE_ADDR, reqSize, scatterLength);
 				CompleteCmd(&hostCmd);
 			}
+			else if( hostCmd.reqInfo.Cmd == IDE_COMMAND_VENDOR_STATS )
+			{
+				// CurSect 1 clears statistics after they are read
+				reqSize = hostCmd.reqInfo.ReqSect * SECTOR_SIZE;
+				if(reqSize > sizeof(struct statsArray))
+					reqSize = sizeof(struct statsArray);
+				scatterLength = hostCmd.reqInfo.HostScatterNum;
+
+				DmaDeviceToHost(&hostCmd, STATS_BASE_ADDR, reqSize, scatterLength);
+				if(hostCmd.reqInfo.CurSect == 1)
+					InitStats();
+				CompleteCmd(&hostCmd);
+			}
+			else if( hostCmd.reqInfo.Cmd == IDE_COMMAND_VENDOR_OVER_PROVISION )
+			{
+				// capacity follows at the next boot, the host has to reread it
+				if(!SetOverProvision(hostCmd.reqInfo.CurSect))
+					hostCmd.CmdStatus = COMMAND_STATUS_INVALID_REQUEST;
+				CompleteCmd(&hostCmd);
+			}
 			else if( hostCmd.reqInfo.Cmd == IDE_COMMAND_SET_FEATURE )
 			{
 				SetIdentifyData(pIdentifyData, &hostCmd);
@@ -228,8 +295,24 @@ void ReqHandler(void)
 			}
 			else if( hostCmd.reqInfo.Cmd == IDE_COMMAND_SMART )
 			{
-				DebugPrint("not support IDE_COMMAND_SMART:%x\r\n", hostCmd.reqInfo.Cmd);
-				hostCmd.CmdStatus = COMMAND_STATUS_INVALID_REQUEST;
+				// SMART sub-command is carried in the low byte of CurSect
+				u32 feature = hostCmd.reqInfo.CurSect & 0xff;
+				if(feature == SMART_READ_DATA)
+				{
+					BuildSmartData(SMART_DATA_BASE_ADDR);
+					scatterLength = hostCmd.reqInfo.HostScatterNum;
+
+					DmaDeviceToHost(&hostCmd, SMART_DATA_BASE_ADDR, SMART_DATA_SIZE, scatterLength);
+				}
+				else if((feature == SMART_ENABLE_OPERATIONS) || (feature == SMART_DISABLE_OPERATIONS) || (feature == SMART_RETURN_STATUS))
+				{
+					// counters are always kept, no threshold is exceeded
+				}
+				else
+				{
+					DebugPrint("not support SMART feature:%x\r\n", feature);
+					hostCmd.CmdStatus = COMMAND_STATUS_INVALID_REQUEST;
+				}
 				CompleteCmd(&hostCmd);
 			}
 			else if( hostCmd.reqInfo.Cmd == IDE_COMMAND_ATAPI_IDENTIFY )
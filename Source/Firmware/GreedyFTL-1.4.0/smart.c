@@ -0,0 +1,288 @@
+//////////////////////////////////////////////////////////////////////////////////
+// smart.c for Cosmos OpenSSD
+// Copyright (c) 2014 Hanyang University ENC Lab.
+// Contributed by Yong Ho Song <yhsong@enc.hanyang.ac.kr>
+//                Gyeongyong Lee <gylee@enc.hanyang.ac.kr>
+//			      Jaewook Kwak <jwkwak@enc.hanyang.ac.kr>
+//
+// This file is part of Cosmos OpenSSD.
+//
+// Cosmos OpenSSD is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3, or (at your option)
+// any later version.
+//
+// Cosmos OpenSSD is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Cosmos OpenSSD; see the file COPYING.
+// If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////
+// Company: ENC Lab. <http://enc.hanyang.ac.kr>
+// Engineer: Gyeongyong Lee <gylee@enc.hanyang.ac.kr>
+//			 Jaewook Kwak <jwkwak@enc.hanyang.ac.kr>
+//
+// Project Name: Cosmos OpenSSD
+// Design Name: Greedy FTL
+// Module Name: SMART
+// File Name: smart.c
+//
+// Version: v1.0.1
+//
+// Description:
+//   - incremental write, program and erase counters
+//   - SMART READ DATA page built from the counters
+//////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////
+// Revision History:
+//
+// * v1.0.1
+//   - count blocks returned to free lists
+//
+// * v1.0.0
+//   - First draft
+//////////////////////////////////////////////////////////////////////////////////
+
+#include "smart.h"
+
+#include "pagemap.h"
+
+#include <string.h>
+
+void InitSmart()
+{
+	smartMap = (struct smartArray*)(SMART_ADDR);
+
+	memset(smartMap, 0, sizeof(struct smartArray));
+	smartMap->magic = SMART_MAGIC;
+
+	ScanSmartBlocks();
+	smartMap->initBadBlockCnt = smartMap->badBlockCnt;
+	smartMap->initFreeBlockCnt = smartMap->freeBlockCnt;
+}
+
+void RecoverSmart()
+{
+	smartMap = (struct smartArray*)(SMART_ADDR);
+
+	// meta data flushed by older firmware has no counters, block derived ones are rebuilt
+	if(smartMap->magic != SMART_MAGIC)
+	{
+		memset(smartMap, 0, sizeof(struct smartArray));
+		smartMap->magic = SMART_MAGIC;
+
+		ScanSmartBlocks();
+		smartMap->initBadBlockCnt = smartMap->badBlockCnt;
+		smartMap->initFreeBlockCnt = smartMap->freeBlockCnt;
+	}
+}
+
+// only at format and recovery, counters are kept up to date afterwards
+void ScanSmartBlocks()
+{
+	smartMap = (struct smartArray*)(SMART_ADDR);
+	blockMap = (struct bmArray*)(BLOCK_MAP_ADDR);
+
+	u32 dieNo, blockNo;
+
+	smartMap->totalEraseCnt = 0;
+	smartMap->maxEraseCnt = 0;
+	smartMap->goodBlockCnt = 0;
+	smartMap->badBlockCnt = 0;
+	smartMap->freeBlockCnt = 0;
+
+	for(dieNo=0 ; dieNo<DIE_NUM ; dieNo++)
+		for(blockNo=0 ; blockNo<BLOCK_NUM_PER_DIE ; blockNo++)
+		{
+			struct bmEntry* block = &blockMap->bmEntry[dieNo][blockNo];
+
+			if(block->bad)
+			{
+				smartMap->badBlockCnt++;
+				continue;
+			}
+
+			smartMap->goodBlockCnt++;
+			if(block->free)
+				smartMap->freeBlockCnt++;
+
+			smartMap->totalEraseCnt += block->eraseCnt;
+			if(block->eraseCnt > smartMap->maxEraseCnt)
+				smartMap->maxEraseCnt = block->eraseCnt;
+		}
+
+	ScanMinEraseCnt();
+}
+
+// called when the last block at the minimum erase count is erased, minimum rises at most once per erase of all good blocks
+void ScanMinEraseCnt()
+{
+	smartMap = (struct smartArray*)(SMART_ADDR);
+	blockMap = (struct bmArray*)(BLOCK_MAP_ADDR);
+
+	u32 dieNo, blockNo;
+
+	smartMap->minEraseCnt = 0xffffffff;
+	smartMap->minEraseBlockCnt = 0;
+
+	for(dieNo=0 ; dieNo<DIE_NUM ; dieNo++)
+		for(blockNo=0 ; blockNo<BLOCK_NUM_PER_DIE ; blockNo++)
+		{
+			struct bmEntry* block = &blockMap->bmEntry[dieNo][blockNo];
+
+			if(block->bad)
+				continue;
+
+			if(block->eraseCnt < smartMap->minEraseCnt)
+			{
+				smartMap->minEraseCnt = block->eraseCnt;
+				smartMap->minEraseBlockCnt = 1;
+			}
+			else if(block->eraseCnt == smartMap->minEraseCnt)
+				smartMap->minEraseBlockCnt++;
+		}
+
+	if(!smartMap->minEraseBlockCnt)
+		smartMap->minEraseCnt = 0;
+}
+
+void SmartHostWrite(u32 sectCnt)
+{
+	smartMap = (struct smartArray*)(SMART_ADDR);
+
+	smartMap->hostWriteSect += sectCnt;
+}
+
+void SmartProgram()
+{
+	smartMap = (struct smartArray*)(SMART_ADDR);
+
+	smartMap->nandProgPage++;
+}
+
+void SmartGcProgram()
+{
+	smartMap = (struct smartArray*)(SMART_ADDR);
+
+	smartMap->gcProgPage++;
+}
+
+// called after erase count of the block is increased
+void SmartErase(u32 dieNo, u32 blockNo)
+{
+	smartMap = (struct smartArray*)(SMART_ADDR);
+	blockMap = (struct bmArray*)(BLOCK_MAP_ADDR);
+
+	u32 eraseCnt = blockMap->bmEntry[dieNo][blockNo].eraseCnt;
+
+	smartMap->totalEraseCnt++;
+	if(eraseCnt > smartMap->maxEraseCnt)
+		smartMap->maxEraseCnt = eraseCnt;
+
+	if(eraseCnt - 1 == smartMap->minEraseCnt)
+	{
+		smartMap->minEraseBlockCnt--;
+		if(!smartMap->minEraseBlockCnt)
+			ScanMinEraseCnt();
+	}
+}
+
+// a free block is taken as the current block or GC block of a die
+void SmartAllocBlock()
+{
+	smartMap = (struct smartArray*)(SMART_ADDR);
+
+	smartMap->freeBlockCnt--;
+}
+
+// an erased block returns to the free list
+void SmartFreeBlock()
+{
+	smartMap = (struct smartArray*)(SMART_ADDR);
+
+	smartMap->freeBlockCnt++;
+}
+
+static void SetSmartAttribute(u8* attr, u8 id, u16 flags, u8 value, u64 raw)
+{
+	int i;
+
+	attr[0] = id;
+	attr[1] = flags & 0xff;
+	attr[2] = flags >> 8;
+	attr[3] = value;
+	attr[4] = value;	// worst value is not tracked, current one is reported
+	for(i=0 ; i<6 ; i++)
+		attr[5 + i] = (raw >> (8 * i)) & 0xff;
+	attr[11] = 0;
+}
+
+static u8 WearValue(u32 eraseCnt)
+{
+	if(eraseCnt >= RATED_ERASE_CNT)
+		return 1;
+	return 100 - (eraseCnt * 100) / RATED_ERASE_CNT;
+}
+
+// 512-byte SMART data structure: revision, 30 attributes of 12 bytes, checksum in the last byte
+void BuildSmartData(u32 bufAddr)
+{
+	smartMap = (struct smartArray*)(SMART_ADDR);
+
+	u8* data = (u8*)bufAddr;
+	u8* attr = data + 2;
+	u8 value, sum;
+	u32 avgEraseCnt;
+	int i;
+
+	memset(data, 0, SMART_DATA_SIZE);
+	data[0] = SMART_REVISION & 0xff;
+	data[1] = SMART_REVISION >> 8;
+
+	avgEraseCnt = smartMap->goodBlockCnt ? (u32)(smartMap->totalEraseCnt / smartMap->goodBlockCnt) : 0;
+
+	SetSmartAttribute(attr, SMART_ID_GROWN_BAD_BLOCK, SMART_ATTR_FLAG_PREFAIL | SMART_ATTR_FLAG_ONLINE, 100,
+			smartMap->badBlockCnt - smartMap->initBadBlockCnt);
+	attr += 12;
+
+	SetSmartAttribute(attr, SMART_ID_MAX_ERASE_CNT, SMART_ATTR_FLAG_ONLINE, WearValue(smartMap->maxEraseCnt), smartMap->maxEraseCnt);
+	attr += 12;
+
+	SetSmartAttribute(attr, SMART_ID_MIN_ERASE_CNT, SMART_ATTR_FLAG_ONLINE, WearValue(smartMap->minEraseCnt), smartMap->minEraseCnt);
+	attr += 12;
+
+	value = 100;
+	if(smartMap->initFreeBlockCnt)
+		value = (u8)(((u64)smartMap->freeBlockCnt * 100) / smartMap->initFreeBlockCnt);
+	if(!value)
+		value = 1;
+	SetSmartAttribute(attr, SMART_ID_SPARE_BLOCK, SMART_ATTR_FLAG_PREFAIL | SMART_ATTR_FLAG_ONLINE, value, smartMap->freeBlockCnt);
+	attr += 12;
+
+	SetSmartAttribute(attr, SMART_ID_AVG_ERASE_CNT, SMART_ATTR_FLAG_ONLINE, WearValue(avgEraseCnt), avgEraseCnt);
+	attr += 12;
+
+	SetSmartAttribute(attr, SMART_ID_HOST_WRITE_SECT, SMART_ATTR_FLAG_ONLINE, 100, smartMap->hostWriteSect);
+	attr += 12;
+
+	SetSmartAttribute(attr, SMART_ID_HOST_PROG_PAGE, SMART_ATTR_FLAG_ONLINE, 100,
+			(smartMap->hostWriteSect + SECTOR_NUM_PER_PAGE - 1) / SECTOR_NUM_PER_PAGE);
+	attr += 12;
+
+	SetSmartAttribute(attr, SMART_ID_NAND_PROG_PAGE, SMART_ATTR_FLAG_ONLINE, 100, smartMap->nandProgPage);
+	attr += 12;
+
+	SetSmartAttribute(attr, SMART_ID_GC_PROG_PAGE, SMART_ATTR_FLAG_ONLINE, 100, smartMap->gcProgPage);
+
+
+	sum = 0;
+	for(i=0 ; i<SMART_DATA_SIZE - 1 ; i++)
+		sum += data[i];
+	data[SMART_DATA_SIZE - 1] = (u8)(0x100 - sum);
+}
@@ -0,0 +1,121 @@
+//////////////////////////////////////////////////////////////////////////////////
+// smart.h for Cosmos OpenSSD
+// Copyright (c) 2014 Hanyang University ENC Lab.
+// Contributed by Yong Ho Song <yhsong@enc.hanyang.ac.kr>
+//                Gyeongyong Lee <gylee@enc.hanyang.ac.kr>
+//			      Jaewook Kwak <jwkwak@enc.hanyang.ac.kr>
+//
+// This file is part of Cosmos OpenSSD.
+//
+// Cosmos OpenSSD is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3, or (at your option)
+// any later version.
+//
+// Cosmos OpenSSD is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Cosmos OpenSSD; see the file COPYING.
+// If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////
+// Company: ENC Lab. <http://enc.hanyang.ac.kr>
+// Engineer: Gyeongyong Lee <gylee@enc.hanyang.ac.kr>
+//			 Jaewook Kwak <jwkwak@enc.hanyang.ac.kr>
+//
+// Project Name: Cosmos OpenSSD
+// Design Name: Greedy FTL
+// Module Name: SMART
+// File Name: smart.h
+//
+// Version: v1.0.1
+//
+// Description:
+//   - define health counters reported by SMART READ DATA
+//////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////
+// Revision History:
+//
+// * v1.0.1
+//   - add counter update for freed blocks
+//
+// * v1.0.0
+//   - First draft
+//////////////////////////////////////////////////////////////////////////////////
+
+#ifndef SMART_H_
+#define SMART_H_
+
+#include "xil_types.h"
+#include "ftl.h"
+
+#define SMART_MAGIC				0x534d5254	// "SMRT"
+
+// SMART sub-commands carried in the low byte of CurSect
+#define SMART_READ_DATA			0xD0
+#define SMART_ENABLE_OPERATIONS	0xD8
+#define SMART_DISABLE_OPERATIONS	0xD9
+#define SMART_RETURN_STATUS		0xDA
+
+#define SMART_DATA_SIZE			512
+#define SMART_ATTRIBUTE_NUM		30
+#define SMART_REVISION			0x0010
+
+// attribute IDs
+#define SMART_ID_GROWN_BAD_BLOCK	5	// blocks retired after format
+#define SMART_ID_MAX_ERASE_CNT		165
+#define SMART_ID_MIN_ERASE_CNT		166
+#define SMART_ID_SPARE_BLOCK		170	// free blocks left for allocation
+#define SMART_ID_AVG_ERASE_CNT		173
+#define SMART_ID_HOST_WRITE_SECT	241	// total LBAs written
+#define SMART_ID_HOST_PROG_PAGE		247	// host pages written
+#define SMART_ID_NAND_PROG_PAGE		248	// NAND pages programmed
+#define SMART_ID_GC_PROG_PAGE		249	// NAND pages programmed by GC migration
+
+#define SMART_ATTR_FLAG_PREFAIL		0x0001
+#define SMART_ATTR_FLAG_ONLINE		0x0002
+
+// rated program/erase cycles of a block, normalizes erase count attributes
+#define RATED_ERASE_CNT			3000
+
+// kept in meta data range and updated as events happen, never by scanning block map
+// 64-bit counters are 8-byte aligned
+struct smartArray {
+	u32 magic;
+	u32 reserved;
+	u64 hostWriteSect;
+	u64 nandProgPage;
+	u64 gcProgPage;
+	u64 totalEraseCnt;	// sum of erase counts of good blocks
+	u32 maxEraseCnt;
+	u32 minEraseCnt;
+	u32 minEraseBlockCnt;	// good blocks whose erase count is minEraseCnt
+	u32 goodBlockCnt;
+	u32 initBadBlockCnt;	// bad blocks found at format
+	u32 badBlockCnt;
+	u32 initFreeBlockCnt;	// free blocks at format
+	u32 freeBlockCnt;
+};
+
+struct smartArray* smartMap;
+
+void InitSmart();
+void RecoverSmart();
+void ScanSmartBlocks();
+void ScanMinEraseCnt();
+
+void SmartHostWrite(u32 sectCnt);
+void SmartProgram();
+void SmartGcProgram();
+void SmartErase(u32 dieNo, u32 blockNo);
+void SmartAllocBlock();
+void SmartFreeBlock();
+
+void BuildSmartData(u32 bufAddr);
+
+#endif /* SMART_H_ */
@@ -0,0 +1,167 @@
+//////////////////////////////////////////////////////////////////////////////////
+// stats.c for Cosmos OpenSSD
+// Copyright (c) 2014 Hanyang University ENC Lab.
+// Contributed by Yong Ho Song <yhsong@enc.hanyang.ac.kr>
+//                Gyeongyong Lee <gylee@enc.hanyang.ac.kr>
+//				  Jaewook Kwak <jwkwak@@enc.hanyang.ac.kr>
+//
+// This file is part of Cosmos OpenSSD.
+//
+// Cosmos OpenSSD is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3, or (at your option)
+// any later version.
+//
+// Cosmos OpenSSD is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Cosmos OpenSSD; see the file COPYING.
+// If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////
+// Company: ENC Lab. <http://enc.hanyang.ac.kr>
+// Engineer: Gyeongyong Lee <gylee@enc.hanyang.ac.kr>
+//			 Jaewook Kwak <jwkwak@enc.hanyang.ac.kr>
+//
+// Project Name: Cosmos OpenSSD
+// Design Name: Greedy FTL
+// Module Name: Statistics
+// File Name: stats.c
+//
+// Version: v1.0.0
+//
+// Description:
+//   - per-command timestamps from global timer
+//   - log2 latency histograms per command type and busy time of each die
+//////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////
+// Revision History:
+//
+// * v1.0.0
+//   - First draft
+//////////////////////////////////////////////////////////////////////////////////
+
+#include "stats.h"
+
+#include "ata.h"
+
+#include <string.h>
+
+void InitStats()
+{
+	statsMap = (struct statsArray*)(STATS_BASE_ADDR);
+
+	memset(statsMap, 0, sizeof(struct statsArray));
+	statsMap->magic = STATS_MAGIC;
+	statsMap->timerFreq = COUNTS_PER_SECOND;
+}
+
+void StatsCmdStart(u32 cmd)
+{
+	statsMap = (struct statsArray*)(STATS_BASE_ADDR);
+
+	XTime now;
+	XTime_GetTime(&now);
+
+	if((cmd == IDE_COMMAND_READ_DMA) || (cmd == IDE_COMMAND_READ))
+		statsMap->curType = STATS_CMD_READ;
+	else if((cmd == IDE_COMMAND_WRITE_DMA) || (cmd == IDE_COMMAND_WRITE) || (cmd == IDE_COMMAND_WRITE_DMA_FUA_EXT))
+		statsMap->curType = STATS_CMD_WRITE;
+	else if((cmd == IDE_COMMAND_FLUSH_CACHE) || (cmd == IDE_COMMAND_FLUSH_CACHE_EXT))
+		statsMap->curType = STATS_CMD_FLUSH;
+	else
+		statsMap->curType = STATS_CMD_OTHER;
+
+	memset(statsMap->curCmd, 0, sizeof(statsMap->curCmd));
+	statsMap->curCmd[STATS_STAGE_FETCH] = now;
+	statsMap->curActive = 1;
+}
+
+void StatsCmdStage(u32 stage)
+{
+	statsMap = (struct statsArray*)(STATS_BASE_ADDR);
+
+	if(!statsMap->curActive)
+		return;
+
+	// first NAND operation is kept, the other stages are stamped by the last event
+	if((stage == STATS_STAGE_NAND_ISSUE) && statsMap->curCmd[stage])
+		return;
+
+	XTime now;
+	XTime_GetTime(&now);
+	statsMap->curCmd[stage] = now;
+}
+
+void StatsCmdEnd()
+{
+	statsMap = (struct statsArray*)(STATS_BASE_ADDR);
+
+	if(!statsMap->curActive)
+		return;
+
+	StatsCmdStage(STATS_STAGE_COMPLETE);
+
+	u32 type = statsMap->curType;
+	u64 ticks;
+	int stage, bin;
+	for(stage=STATS_STAGE_NAND_ISSUE ; stage<STATS_STAGE_NUM ; stage++)
+	{
+		if(statsMap->curCmd[stage] == 0)
+			continue;
+
+		ticks = statsMap->curCmd[stage] - statsMap->curCmd[STATS_STAGE_FETCH];
+		if(ticks >> 32)
+			bin = STATS_HIST_BIN_NUM - 1;
+		else if(ticks == 0)
+			bin = 0;
+		else
+			bin = 32 - __builtin_clz((u32)ticks);
+		if(bin >= STATS_HIST_BIN_NUM)
+			bin = STATS_HIST_BIN_NUM - 1;
+
+		statsMap->latHist[type][stage - 1][bin]++;
+	}
+
+	statsMap->cmdCnt[type]++;
+	memcpy(statsMap->lastCmd, statsMap->curCmd, sizeof(statsMap->lastCmd));
+	statsMap->curActive = 0;
+}
+
+void StatsDieIssue(u32 dieNo)
+{
+	statsMap = (struct statsArray*)(STATS_BASE_ADDR);
+
+	XTime now;
+	XTime_GetTime(&now);
+
+	// an operation issued to a die not seen idle ends now
+	if(statsMap->dieIssue[dieNo])
+		statsMap->dieBusy[dieNo] += now - statsMap->dieIssue[dieNo];
+
+	statsMap->dieIssue[dieNo] = now;
+	statsMap->dieOpCnt[dieNo]++;
+
+	StatsCmdStage(STATS_STAGE_NAND_ISSUE);
+}
+
+void StatsDieDone(u32 dieNo)
+{
+	statsMap = (struct statsArray*)(STATS_BASE_ADDR);
+
+	if(statsMap->dieIssue[dieNo] == 0)
+		return;
+
+	XTime now;
+	XTime_GetTime(&now);
+
+	statsMap->dieBusy[dieNo] += now - statsMap->dieIssue[dieNo];
+	statsMap->dieIssue[dieNo] = 0;
+
+	StatsCmdStage(STATS_STAGE_NAND_DONE);
+}
@@ -0,0 +1,101 @@
+//////////////////////////////////////////////////////////////////////////////////
+// stats.h for Cosmos OpenSSD
+// Copyright (c) 2014 Hanyang University ENC Lab.
+// Contributed by Yong Ho Song <yhsong@enc.hanyang.ac.kr>
+//                Gyeongyong Lee <gylee@enc.hanyang.ac.kr>
+//			      Jaewook Kwak <jwkwak@enc.hanyang.ac.kr>
+//
+// This file is part of Cosmos OpenSSD.
+//
+// Cosmos OpenSSD is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3, or (at your option)
+// any later version.
+//
+// Cosmos OpenSSD is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Cosmos OpenSSD; see the file COPYING.
+// If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////
+// Company: ENC Lab. <http://enc.hanyang.ac.kr>
+// Engineer: Gyeongyong Lee <gylee@enc.hanyang.ac.kr>
+//			 Jaewook Kwak <jwkwak@enc.hanyang.ac.kr>
+//
+// Project Name: Cosmos OpenSSD
+// Design Name: Greedy FTL
+// Module Name: Statistics
+// File Name: stats.h
+//
+// Version: v1.0.0
+//
+// Description:
+//   - define latency histograms and die busy counters read by host
+//////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////
+// Revision History:
+//
+// * v1.0.0
+//   - First draft
+//////////////////////////////////////////////////////////////////////////////////
+
+#ifndef STATS_H_
+#define STATS_H_
+
+#include "xil_types.h"
+#include "xtime_l.h"
+#include "host_controller.h"
+#include "ftl.h"
+
+#define STATS_MAGIC				0x53544154	// "STAT"
+
+// stages of a command stamped by global timer
+#define STATS_STAGE_FETCH		0	// request is fetched
+#define STATS_STAGE_NAND_ISSUE	1	// first NAND operation is issued
+#define STATS_STAGE_NAND_DONE	2	// last NAND operation is done
+#define STATS_STAGE_DMA_DONE	3	// last data DMA is done
+#define STATS_STAGE_COMPLETE	4	// completion is staged
+#define STATS_STAGE_NUM			5
+
+#define STATS_CMD_READ			0
+#define STATS_CMD_WRITE			1
+#define STATS_CMD_FLUSH			2
+#define STATS_CMD_OTHER			3
+#define STATS_CMD_TYPE_NUM		4
+
+// bin n counts latencies of [2^(n-1), 2^n) ticks, bin 0 counts zero
+#define STATS_HIST_BIN_NUM		32
+
+// read by host as it is, 64-bit counters are 8-byte aligned
+struct statsArray {
+	u32 magic;
+	u32 timerFreq;	// global timer ticks per second
+	u32 cmdCnt[STATS_CMD_TYPE_NUM];
+	u32 latHist[STATS_CMD_TYPE_NUM][STATS_STAGE_NUM - 1][STATS_HIST_BIN_NUM];	// ticks from fetch to each later stage
+	u64 dieBusy[DIE_NUM];	// ticks each die spent on NAND operations
+	u32 dieOpCnt[DIE_NUM];
+	u64 lastCmd[STATS_STAGE_NUM];	// timestamps of the last completed command, 0 for a stage not reached
+
+	// command in progress
+	u64 curCmd[STATS_STAGE_NUM];
+	u32 curType;
+	u32 curActive;
+	u64 dieIssue[DIE_NUM];	// issue time of NAND operation in progress at each die, 0 for idle
+};
+
+struct statsArray* statsMap;
+
+void InitStats();
+void StatsCmdStart(u32 cmd);
+void StatsCmdStage(u32 stage);
+void StatsCmdEnd();
+void StatsDieIssue(u32 dieNo);
+void StatsDieDone(u32 dieNo);
+
+#endif /* STATS_H_ */
@@ -0,0 +1,237 @@
+//////////////////////////////////////////////////////////////////////////////////
+// wear_level.c for Cosmos OpenSSD
+// Copyright (c) 2014 Hanyang University ENC Lab.
+// Contributed by Yong Ho Song <yhsong@enc.hanyang.ac.kr>
+//                Gyeongyong Lee <gylee@enc.hanyang.ac.kr>
+//			      Jaewook Kwak <jwkwak@enc.hanyang.ac.kr>
+//
+// This file is part of Cosmos OpenSSD.
+//
+// Cosmos OpenSSD is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3, or (at your option)
+// any later version.
+//
+// Cosmos OpenSSD is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Cosmos OpenSSD; see the file COPYING.
+// If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////
+// Company: ENC Lab. <http://enc.hanyang.ac.kr>
+// Engineer: Gyeongyong Lee <gylee@enc.hanyang.ac.kr>
+//			 Jaewook Kwak <jwkwak@enc.hanyang.ac.kr>
+//
+// Project Name: Cosmos OpenSSD
+// Design Name: Greedy FTL
+// Module Name: Wear Leveling
+// File Name: wear_level.c
+//
+// Version: v1.0.5
+//
+// Description:
+//   - static wear leveling, valid data of a cold block is moved out in idle time
+//////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////
+// Revision History:
+//
+// * v1.0.5
+//   - cold page is read through the I/O scheduler
+//
+// * v1.0.4
+//   - P2L entries are read by GetP2L()
+//
+// * v1.0.3
+//   - live slots of container pages are rewritten through compression
+//
+// * v1.0.2
+//   - open blocks of all write streams are skipped as cold block
+//
+// * v1.0.1
+//   - least worn free block is allocated from free lists of page map
+//
+// * v1.0.0
+//   - First draft
+//////////////////////////////////////////////////////////////////////////////////
+
+#include "wear_level.h"
+
+#include "lld.h"
+#include "pagemap.h"
+
+void InitWearLevel()
+{
+	wlMap = (struct wlArray*)(WL_MAP_ADDR);
+
+	wlMap->active = 0;
+	wlMap->checkedEraseCnt = 0xffffffffffffffffULL;
+
+	xil_printf("[ ssd wear leveling initialized. ]\r\n");
+}
+
+// a page of cold data is moved per call, so a request arriving meanwhile waits for one page migration at most
+void WearLevelIdle()
+{
+	wlMap = (struct wlArray*)(WL_MAP_ADDR);
+	smartMap = (struct smartArray*)(SMART_ADDR);
+
+	if(!wlMap->active)
+	{
+		// erase counts have not changed since the last search
+		if(smartMap->totalEraseCnt == wlMap->checkedEraseCnt)
+			return;
+		wlMap->checkedEraseCnt = smartMap->totalEraseCnt;
+
+		if(smartMap->maxEraseCnt - smartMap->minEraseCnt <= WEAR_LEVEL_THRESHOLD)
+			return;
+
+		if(!FindColdBlock())
+			return;
+	}
+
+	MigrateColdPage();
+}
+
+// block holding valid data with the widest gap to the most worn block of its die
+int FindColdBlock()
+{
+	wlMap = (struct wlArray*)(WL_MAP_ADDR);
+	blockMap = (struct bmArray*)(BLOCK_MAP_ADDR);
+	dieBlock = (struct dieArray*)(DIE_MAP_ADDR);
+
+	u32 dieNo, blockNo, maxEraseCnt, coldBlock, coldEraseCnt, gap;
+	struct bmEntry* block;
+
+	gap = WEAR_LEVEL_THRESHOLD;
+	for(dieNo=0 ; dieNo<DIE_NUM ; dieNo++)
+	{
+		maxEraseCnt = 0;
+		coldBlock = 0xffffffff;
+		coldEraseCnt = 0xffffffff;
+
+		for(blockNo=0 ; blockNo<BLOCK_NUM_PER_DIE ; blockNo++)
+		{
+			block = &blockMap->bmEntry[dieNo][blockNo];
+			if(block->bad)
+				continue;
+
+			if(block->eraseCnt > maxEraseCnt)
+				maxEraseCnt = block->eraseCnt;
+
+			if((block->eraseCnt < coldEraseCnt) && !block->free && !block->open
+					&& (blockNo != dieBlock->dieEntry[dieNo].freeBlock) && CountValid(dieNo, blockNo))
+			{
+				coldBlock = blockNo;
+				coldEraseCnt = block->eraseCnt;
+			}
+		}
+
+		if((coldBlock != 0xffffffff) && (maxEraseCnt - coldEraseCnt > gap))
+		{
+			gap = maxEraseCnt - coldEraseCnt;
+			wlMap->dieNo = dieNo;
+			wlMap->blockNo = coldBlock;
+			wlMap->eraseCnt = coldEraseCnt;
+		}
+	}
+
+	if(gap == WEAR_LEVEL_THRESHOLD)
+		return 0;
+
+	wlMap->nextPage = 0;
+	wlMap->active = 1;
+
+	return 1;
+}
+
+// compressed pages still mapped to a container page in wear leveling buffer are written again
+void MigrateContainer(u32 dieNo, u32 page)
+{
+	wlMap = (struct wlArray*)(WL_MAP_ADDR);
+	blockMap = (struct bmArray*)(BLOCK_MAP_ADDR);
+
+	struct compHeader* header = (struct compHeader*)WL_BUFFER_ADDR;
+	u32 slot, mask, bufAddr;
+	int i;
+
+	for(slot=0 ; slot<header->slotCnt ; slot++)
+	{
+		// rewriting may run GC, which moves or erases the container page
+		if(blockMap->bmEntry[dieNo][wlMap->blockNo].eraseCnt != wlMap->eraseCnt)
+			return;
+
+		mask = 0;
+		for(i=0 ; i<SUB_PAGE_NUM_PER_PAGE ; i++)
+			if(GetL2P(dieNo, header->slot[slot].dieLpn + i) == COMP_ENTRY(page, slot, i))
+				mask |= 1 << i;
+		if(mask == 0)
+			continue;
+
+		bufAddr = AllocWriteBuf();
+		Lz4Decompress(WL_BUFFER_ADDR + header->slot[slot].offset, header->slot[slot].length, bufAddr, PAGE_SIZE);
+
+		if((mask != (1 << SUB_PAGE_NUM_PER_PAGE) - 1) || !CompressPage(dieNo, header->slot[slot].dieLpn, bufAddr))
+			for(i=0 ; i<SUB_PAGE_NUM_PER_PAGE ; i++)
+				if(mask & (1 << i))
+					PackSubPage(dieNo, header->slot[slot].dieLpn + i, bufAddr + i*SUB_PAGE_SIZE);
+
+		FreeWriteBuf(bufAddr);
+	}
+}
+
+// valid sub-pages are rewritten through the packing buffer, the emptied block is reclaimed by GC and takes hot data
+void MigrateColdPage()
+{
+	wlMap = (struct wlArray*)(WL_MAP_ADDR);
+	pageMap = (struct pmArray*)(PAGE_MAP_ADDR);
+	blockMap = (struct bmArray*)(BLOCK_MAP_ADDR);
+
+	u32 dieNo = wlMap->dieNo;
+	u32 blockNo = wlMap->blockNo;
+	u32 pageNo, subPpn;
+	int k, valid;
+
+	for( ; wlMap->nextPage<PAGE_NUM_PER_BLOCK ; wlMap->nextPage++)
+	{
+		// GC may have reclaimed the block already
+		if(blockMap->bmEntry[dieNo][blockNo].eraseCnt != wlMap->eraseCnt)
+			break;
+
+		pageNo = wlMap->nextPage;
+		valid = 0;
+		for(k=0 ; k<SUB_PAGE_NUM_PER_PAGE ; k++)
+			valid |= IsValid(dieNo, blockNo*SUB_PAGE_NUM_PER_BLOCK + pageNo*SUB_PAGE_NUM_PER_PAGE + k);
+		if(!valid)
+			continue;
+
+		WaitWayFree(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM);
+		IoRead(dieNo, IO_CLASS_GC, blockNo*PAGE_NUM_PER_BLOCK + pageNo, WL_BUFFER_ADDR);
+		WaitWayFree(dieNo % CHANNEL_NUM, dieNo / CHANNEL_NUM);
+
+		if(GetP2L(dieNo, blockNo*SUB_PAGE_NUM_PER_BLOCK + pageNo*SUB_PAGE_NUM_PER_PAGE) == CONTAINER_4BYTE)
+		{
+			MigrateContainer(dieNo, blockNo*PAGE_NUM_PER_BLOCK + pageNo);
+			wlMap->nextPage++;
+			return;
+		}
+
+		// packing may flush a page and run GC, validity is checked again for each sub-page
+		for(k=0 ; k<SUB_PAGE_NUM_PER_PAGE ; k++)
+		{
+			subPpn = blockNo*SUB_PAGE_NUM_PER_BLOCK + pageNo*SUB_PAGE_NUM_PER_PAGE + k;
+			if((blockMap->bmEntry[dieNo][blockNo].eraseCnt == wlMap->eraseCnt) && IsValid(dieNo, subPpn))
+				PackSubPage(dieNo, GetP2L(dieNo, subPpn), WL_BUFFER_ADDR + k*SUB_PAGE_SIZE);
+		}
+
+		wlMap->nextPage++;
+		return;
+	}
+
+	wlMap->active = 0;
+}
@@ -0,0 +1,79 @@
+//////////////////////////////////////////////////////////////////////////////////
+// wear_level.h for Cosmos OpenSSD
+// Copyright (c) 2014 Hanyang University ENC Lab.
+// Contributed by Yong Ho Song <yhsong@enc.hanyang.ac.kr>
+//                Gyeongyong Lee <gylee@enc.hanyang.ac.kr>
+//			      Jaewook Kwak <jwkwak@enc.hanyang.ac.kr>
+//
+// This file is part of Cosmos OpenSSD.
+//
+// Cosmos OpenSSD is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3, or (at your option)
+// any later version.
+//
+// Cosmos OpenSSD is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Cosmos OpenSSD; see the file COPYING.
+// If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////
+// Company: ENC Lab. <http://enc.hanyang.ac.kr>
+// Engineer: Gyeongyong Lee <gylee@enc.hanyang.ac.kr>
+//			 Jaewook Kwak <jwkwak@enc.hanyang.ac.kr>
+//
+// Project Name: Cosmos OpenSSD
+// Design Name: Greedy FTL
+// Module Name: Wear Leveling
+// File Name: wear_level.h
+//
+// Version: v1.0.2
+//
+// Description:
+//   - define state of static wear leveling
+//////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////
+// Revision History:
+//
+// * v1.0.2
+//   - add migration of container pages
+//
+// * v1.0.1
+//   - free block allocation is moved to page map
+//
+// * v1.0.0
+//   - First draft
+//////////////////////////////////////////////////////////////////////////////////
+
+#ifndef WEAR_LEVEL_H_
+#define WEAR_LEVEL_H_
+
+#include "xil_types.h"
+#include "ftl.h"
+
+// cold block whose valid data is being moved out while no request waits
+struct wlArray {
+	u32 active;
+	u32 dieNo;
+	u32 blockNo;
+	u32 eraseCnt;	// erase count of the cold block when chosen, migration stops if it is erased meanwhile
+	u32 nextPage;	// next page of the cold block to migrate
+	u32 reserved;
+	u64 checkedEraseCnt;	// total erase count at the last search of a cold block
+};
+
+struct wlArray* wlMap;
+
+void InitWearLevel();
+void WearLevelIdle();
+int FindColdBlock();
+void MigrateColdPage();
+void MigrateContainer(u32 dieNo, u32 page);
+
+#endif /* WEAR_LEVEL_H_ */